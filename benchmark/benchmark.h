@@ -0,0 +1,101 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_BENCHMARK_H
+#define CSLIBGUARDED_BENCHMARK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace benchmark
+{
+
+using benchmark_func = std::function<void()>;
+
+struct registration {
+   registration(std::string name, benchmark_func func);
+};
+
+std::vector<std::pair<std::string, benchmark_func>> &registry();
+
+// thread counts used by every benchmark, 1 to 128
+const std::vector<unsigned> &thread_counts();
+
+std::chrono::milliseconds run_time();
+
+void print_header(const std::string &title, const std::vector<std::string> &columns);
+void print_row(unsigned threads, const std::vector<double> &values);
+
+/**
+   Runs func(thread_index) repeatedly on thread_count threads for
+   run_time() and returns the total number of calls per second.
+*/
+template <typename Func>
+double run_threads(unsigned thread_count, Func func)
+{
+   std::atomic<bool> start = false;
+   std::atomic<bool> stop  = false;
+
+   std::vector<std::uint64_t> counts(thread_count, 0);
+   std::vector<std::thread> threads;
+
+   for (unsigned i = 0; i < thread_count; ++i) {
+      threads.emplace_back([&, i]() {
+         while (! start.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+         }
+
+         std::uint64_t count = 0;
+
+         while (! stop.load(std::memory_order_relaxed)) {
+            func(i);
+            ++count;
+         }
+
+         counts[i] = count;
+      });
+   }
+
+   auto begin = std::chrono::steady_clock::now();
+   start.store(true, std::memory_order_release);
+
+   std::this_thread::sleep_for(run_time());
+   stop.store(true, std::memory_order_relaxed);
+
+   for (auto &th : threads) {
+      th.join();
+   }
+
+   std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+   std::uint64_t total = 0;
+
+   for (auto count : counts) {
+      total += count;
+   }
+
+   return total / elapsed.count();
+}
+
+}  // namespace benchmark
+
+#endif
@@ -0,0 +1,100 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include "benchmark.h"
+
+#include <cs_combining_guarded.h>
+#include <cs_delegated_guarded.h>
+#include <cs_ordered_guarded.h>
+#include <cs_plain_guarded.h>
+
+#include <queue>
+
+using namespace libguarded;
+
+namespace
+{
+
+using priority_queue = std::priority_queue<std::uint64_t>;
+
+// push a value, pop one every other operation so the queue stays small
+void update_queue(priority_queue &queue, std::uint64_t value)
+{
+   queue.push(value);
+
+   if (value % 2 == 0) {
+      queue.pop();
+   }
+}
+
+template <typename T>
+double run_plain_guarded(unsigned threads, void (*update)(T &, std::uint64_t))
+{
+   plain_guarded<T> data;
+
+   struct alignas(64) thread_state {
+      std::uint64_t m_iterations = 0;
+   };
+
+   std::vector<thread_state> state(threads);
+
+   return benchmark::run_threads(threads, [&](unsigned index) {
+      update(*data.lock(), ++state[index].m_iterations);
+   });
+}
+
+// ordered_guarded, combining_guarded, and delegated_guarded all provide modify()
+template <typename Guarded, typename T>
+double run_modify(unsigned threads, void (*update)(T &, std::uint64_t))
+{
+   Guarded data;
+
+   struct alignas(64) thread_state {
+      std::uint64_t m_iterations = 0;
+   };
+
+   std::vector<thread_state> state(threads);
+
+   return benchmark::run_threads(threads, [&](unsigned index) {
+      std::uint64_t value = ++state[index].m_iterations;
+      data.modify([update, value](T &obj) { update(obj, value); });
+   });
+}
+
+template <typename T>
+void run_comparison(const std::string &title, void (*update)(T &, std::uint64_t))
+{
+   benchmark::print_header(title, {"plain_guarded", "ordered_guarded", "combining_guarded", "delegated_guarded"});
+
+   for (unsigned threads : benchmark::thread_counts()) {
+      benchmark::print_row(threads, {
+            run_plain_guarded<T>(threads, update),
+            run_modify<ordered_guarded<T>>(threads, update),
+            run_modify<combining_guarded<T>>(threads, update),
+            run_modify<delegated_guarded<T>>(threads, update)});
+   }
+}
+
+benchmark::registration s_counter("combining_counter", []() {
+   run_comparison<std::uint64_t>("counter increment", [](std::uint64_t &counter, std::uint64_t) { ++counter; });
+});
+
+benchmark::registration s_queue("combining_priority_queue", []() {
+   run_comparison<priority_queue>("priority queue push and pop", update_queue);
+});
+
+}  // namespace
@@ -0,0 +1,92 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace benchmark
+{
+
+static std::chrono::milliseconds s_runTime(200);
+
+registration::registration(std::string name, benchmark_func func)
+{
+   registry().emplace_back(std::move(name), std::move(func));
+}
+
+std::vector<std::pair<std::string, benchmark_func>> &registry()
+{
+   static std::vector<std::pair<std::string, benchmark_func>> retval;
+   return retval;
+}
+
+const std::vector<unsigned> &thread_counts()
+{
+   static const std::vector<unsigned> retval = {1, 2, 4, 8, 16, 32, 64, 128};
+   return retval;
+}
+
+std::chrono::milliseconds run_time()
+{
+   return s_runTime;
+}
+
+void print_header(const std::string &title, const std::vector<std::string> &columns)
+{
+   std::printf("\n%s (operations per second)\n\n%8s", title.c_str(), "threads");
+
+   for (const auto &column : columns) {
+      std::printf("  %24s", column.c_str());
+   }
+
+   std::printf("\n");
+}
+
+void print_row(unsigned threads, const std::vector<double> &values)
+{
+   std::printf("%8u", threads);
+
+   for (double value : values) {
+      std::printf("  %24.0f", value);
+   }
+
+   std::printf("\n");
+   std::fflush(stdout);
+}
+
+}  // namespace benchmark
+
+// usage: CsLibGuardedBenchmark [name filter] [milliseconds per run]
+int main(int argc, char *argv[])
+{
+   const char *filter = argc > 1 ? argv[1] : "";
+
+   if (argc > 2) {
+      benchmark::s_runTime = std::chrono::milliseconds(std::atoi(argv[2]));
+   }
+
+   for (auto &item : benchmark::registry()) {
+      if (std::strstr(item.first.c_str(), filter) != nullptr) {
+         item.second();
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,55 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include "benchmark.h"
+
+#include <cs_adaptive_mutex.h>
+#include <cs_cohort_mutex.h>
+#include <cs_mcs_mutex.h>
+#include <cs_plain_guarded.h>
+
+#include <mutex>
+
+using namespace libguarded;
+
+namespace
+{
+
+// every operation is a short exclusive critical section
+template <typename Mutex>
+double run_plain_guarded(unsigned threads)
+{
+   plain_guarded<std::uint64_t, Mutex> data(0);
+
+   return benchmark::run_threads(threads, [&](unsigned) {
+      ++(*data.lock());
+   });
+}
+
+benchmark::registration s_shortSection("mutex_short_section", []() {
+   benchmark::print_header("plain_guarded, short critical section", {"std::mutex", "adaptive_mutex", "mcs_mutex", "cohort_mutex"});
+
+   for (unsigned threads : benchmark::thread_counts()) {
+      benchmark::print_row(threads, {
+            run_plain_guarded<std::mutex>(threads),
+            run_plain_guarded<adaptive_mutex>(threads),
+            run_plain_guarded<mcs_mutex>(threads),
+            run_plain_guarded<cohort_mutex<>>(threads)});
+   }
+});
+
+}  // namespace
@@ -0,0 +1,72 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include "benchmark.h"
+
+#include <cs_shared_guarded.h>
+#include <cs_sharded_guarded.h>
+
+#include <unordered_map>
+
+using namespace libguarded;
+
+namespace
+{
+
+using map_type = std::unordered_map<std::uint64_t, std::uint64_t>;
+
+constexpr std::uint64_t key_count = 4096;
+
+struct alignas(64) thread_state {
+   std::uint64_t m_iterations = 0;
+};
+
+double run_shared_guarded(unsigned threads)
+{
+   shared_guarded<map_type> data;
+   std::vector<thread_state> state(threads);
+
+   return benchmark::run_threads(threads, [&](unsigned index) {
+      std::uint64_t key = (++state[index].m_iterations * 7919 + index) % key_count;
+      ++(*data.lock())[key];
+   });
+}
+
+template <std::size_t N>
+double run_sharded_guarded(unsigned threads)
+{
+   sharded_guarded<map_type, N> data;
+   std::vector<thread_state> state(threads);
+
+   return benchmark::run_threads(threads, [&](unsigned index) {
+      std::uint64_t key = (++state[index].m_iterations * 7919 + index) % key_count;
+      ++(*data.lock(key))[key];
+   });
+}
+
+benchmark::registration s_writers("sharded_writers", []() {
+   benchmark::print_header("map updates", {"shared_guarded", "sharded_guarded<4>", "sharded_guarded<16>"});
+
+   for (unsigned threads : benchmark::thread_counts()) {
+      benchmark::print_row(threads, {
+            run_shared_guarded(threads),
+            run_sharded_guarded<4>(threads),
+            run_sharded_guarded<16>(threads)});
+   }
+});
+
+}  // namespace
@@ -0,0 +1,76 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include "benchmark.h"
+
+#include <cs_distributed_shared_mutex.h>
+#include <cs_shared_guarded.h>
+
+#include <shared_mutex>
+
+using namespace libguarded;
+
+namespace
+{
+
+// one exclusive lock every write_interval operations, zero for read only
+template <typename Mutex>
+double run_shared_guarded(unsigned threads, unsigned write_interval)
+{
+   shared_guarded<std::uint64_t, Mutex> data(0);
+
+   // per thread state on separate cache lines so only the mutex is contended
+   struct alignas(64) thread_state {
+      std::uint64_t m_iterations = 0;
+      std::uint64_t m_sum        = 0;
+   };
+
+   std::vector<thread_state> state(threads);
+
+   return benchmark::run_threads(threads, [&](unsigned index) {
+      thread_state &local = state[index];
+
+      if (write_interval != 0 && ++local.m_iterations % write_interval == 0) {
+         ++(*data.lock());
+
+      } else {
+         local.m_sum += *data.lock_shared();
+      }
+   });
+}
+
+void run_comparison(const std::string &title, unsigned write_interval)
+{
+   benchmark::print_header(title, {"std::shared_mutex", "std::shared_timed_mutex", "distributed_shared_mutex"});
+
+   for (unsigned threads : benchmark::thread_counts()) {
+      benchmark::print_row(threads, {
+            run_shared_guarded<std::shared_mutex>(threads, write_interval),
+            run_shared_guarded<std::shared_timed_mutex>(threads, write_interval),
+            run_shared_guarded<distributed_shared_mutex>(threads, write_interval)});
+   }
+}
+
+benchmark::registration s_readOnly("shared_mutex_read", []() {
+   run_comparison("shared_guarded, read only", 0);
+});
+
+benchmark::registration s_readMostly("shared_mutex_read_mostly", []() {
+   run_comparison("shared_guarded, one write per 1000 operations", 1000);
+});
+
+}  // namespace
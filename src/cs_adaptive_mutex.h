@@ -0,0 +1,136 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_ADAPTIVE_MUTEX_H
+#define CSLIBGUARDED_ADAPTIVE_MUTEX_H
+
+#include "cs_spin_wait.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_adaptive_mutex.h <CsLibGuarded/cs_adaptive_mutex.h>
+
+   This class is a mutex which meets the requirements of TimedMutex and
+   can be used as the mutex type for plain_guarded and the other guarded
+   classes which take an exclusive mutex.
+
+   A thread which finds the mutex locked first spins, then sleeps using
+   std::atomic::wait. The number of spins adapts to how long the mutex was
+   recently held, so short critical sections are usually acquired without
+   sleeping while long critical sections do not waste processor time.
+
+   The timed lock methods poll until the timeout expires.
+*/
+class adaptive_mutex
+{
+   public:
+      // upper bound for the adaptive spin count
+      static constexpr std::int32_t max_spin = 1000;
+
+      adaptive_mutex() = default;
+
+      adaptive_mutex(const adaptive_mutex &) = delete;
+      adaptive_mutex &operator=(const adaptive_mutex &) = delete;
+
+      void lock() {
+         std::uint32_t expected = unlocked;
+
+         if (! m_state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed)) {
+            lock_slow();
+         }
+      }
+
+      bool try_lock() {
+         std::uint32_t expected = unlocked;
+         return m_state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+      }
+
+      template <class Duration>
+      bool try_lock_for(const Duration &duration) {
+         return try_lock_until(std::chrono::steady_clock::now() + duration);
+      }
+
+      template <class TimePoint>
+      bool try_lock_until(const TimePoint &timepoint);
+
+      void unlock() {
+         if (m_state.exchange(unlocked, std::memory_order_release) == contended) {
+            m_state.notify_one();
+         }
+      }
+
+   private:
+      static constexpr std::uint32_t unlocked  = 0;
+      static constexpr std::uint32_t locked    = 1;
+      static constexpr std::uint32_t contended = 2;
+
+      void lock_slow();
+
+      std::atomic<std::uint32_t> m_state = unlocked;
+
+      // moving average of the spins needed to acquire the mutex
+      std::atomic<std::int32_t> m_spinEstimate = 0;
+};
+
+inline void adaptive_mutex::lock_slow()
+{
+   std::int32_t estimate = m_spinEstimate.load(std::memory_order_relaxed);
+   std::int32_t limit    = std::min(max_spin, estimate * 2 + 10);
+
+   for (std::int32_t spins = 0; spins < limit; ++spins) {
+      if (m_state.load(std::memory_order_relaxed) == unlocked && try_lock()) {
+         m_spinEstimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+         return;
+      }
+
+      detail::cpu_relax();
+   }
+
+   m_spinEstimate.store(estimate + (limit - estimate) / 8, std::memory_order_relaxed);
+
+   // the state is left as contended so the eventual owner wakes the next waiter
+   while (m_state.exchange(contended, std::memory_order_acquire) != unlocked) {
+      m_state.wait(contended, std::memory_order_relaxed);
+   }
+}
+
+template <class TimePoint>
+bool adaptive_mutex::try_lock_until(const TimePoint &timepoint)
+{
+   detail::spin_wait backoff;
+
+   while (! try_lock()) {
+      if (TimePoint::clock::now() >= timepoint) {
+         return false;
+      }
+
+      backoff.wait();
+   }
+
+   return true;
+}
+
+}  // namespace libguarded
+
+#endif
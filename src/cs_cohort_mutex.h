@@ -0,0 +1,401 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_COHORT_MUTEX_H
+#define CSLIBGUARDED_COHORT_MUTEX_H
+
+#include "cs_adaptive_mutex.h"
+#include "cs_distributed_shared_mutex.h"
+#include "cs_spin_wait.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_cohort_mutex.h <CsLibGuarded/cs_cohort_mutex.h>
+
+   Topology of the NUMA nodes on Linux, read from /sys the first time it
+   is used. The node of the calling thread is found from the processor it
+   is currently running on. On other platforms, or when the information is
+   not available, there is a single node.
+*/
+class linux_topology
+{
+   public:
+      std::size_t node_count() const {
+         return table().m_nodeCount;
+      }
+
+      std::size_t current_node() const {
+#if defined(__linux__)
+         const topology_table &data = table();
+         int cpu = sched_getcpu();
+
+         if (cpu >= 0 && static_cast<std::size_t>(cpu) < data.m_cpuNodes.size()) {
+            return data.m_cpuNodes[cpu];
+         }
+#endif
+
+         return 0;
+      }
+
+   private:
+      struct topology_table {
+         std::size_t m_nodeCount = 1;
+
+         // dense node index for each processor number
+         std::vector<std::size_t> m_cpuNodes;
+      };
+
+      // parses a list such as "0-3,8,10-11"
+      static std::vector<std::size_t> parse_list(const std::string &text) {
+         std::vector<std::size_t> retval;
+         std::size_t pos = 0;
+
+         while (pos < text.size()) {
+            std::size_t end = text.find(',', pos);
+
+            if (end == std::string::npos) {
+               end = text.size();
+            }
+
+            std::string item = text.substr(pos, end - pos);
+            std::size_t dash = item.find('-');
+
+            try {
+               std::size_t first = std::stoul(item.substr(0, dash));
+               std::size_t last  = (dash == std::string::npos) ? first : std::stoul(item.substr(dash + 1));
+
+               for (std::size_t i = first; i <= last; ++i) {
+                  retval.push_back(i);
+               }
+
+            } catch (...) {
+               return {};
+            }
+
+            pos = end + 1;
+         }
+
+         return retval;
+      }
+
+      static std::string read_line(const std::string &path) {
+         std::ifstream file(path);
+         std::string retval;
+
+         std::getline(file, retval);
+
+         return retval;
+      }
+
+      static topology_table load_table() {
+         topology_table retval;
+
+#if defined(__linux__)
+         const std::string root = "/sys/devices/system/node/";
+
+         std::vector<std::size_t> nodes = parse_list(read_line(root + "online"));
+
+         if (nodes.size() <= 1) {
+            return retval;
+         }
+
+         for (std::size_t index = 0; index < nodes.size(); ++index) {
+            std::string path = root + "node" + std::to_string(nodes[index]) + "/cpulist";
+
+            for (std::size_t cpu : parse_list(read_line(path))) {
+               if (cpu >= retval.m_cpuNodes.size()) {
+                  retval.m_cpuNodes.resize(cpu + 1, 0);
+               }
+
+               retval.m_cpuNodes[cpu] = index;
+            }
+         }
+
+         retval.m_nodeCount = nodes.size();
+#endif
+
+         return retval;
+      }
+
+      static const topology_table &table() {
+         static const topology_table data = load_table();
+         return data;
+      }
+};
+
+/**
+   \headerfile cs_cohort_mutex.h <CsLibGuarded/cs_cohort_mutex.h>
+
+   Topology with a fixed number of nodes where each thread selects its
+   own node. Used to test cohort_mutex on a machine with a single node.
+*/
+template <std::size_t Nodes>
+class fake_topology
+{
+   static_assert(Nodes > 0, "fake_topology requires at least one node");
+
+   public:
+      std::size_t node_count() const {
+         return Nodes;
+      }
+
+      std::size_t current_node() const {
+         return thread_node() % Nodes;
+      }
+
+      // applies to the calling thread only, the default is node zero
+      static void set_current_node(std::size_t node) {
+         thread_node() = node;
+      }
+
+   private:
+      static std::size_t &thread_node() {
+         thread_local std::size_t node = 0;
+         return node;
+      }
+};
+
+/**
+   \headerfile cs_cohort_mutex.h <CsLibGuarded/cs_cohort_mutex.h>
+
+   This templated class is a NUMA aware mutex which meets the
+   requirements of TimedMutex and can be used as the mutex type for
+   plain_guarded and the other guarded classes which take an exclusive
+   mutex.
+
+   Each node of the Topology has a local mutex and the nodes share a
+   global mutex. A thread first acquires the mutex of its own node, then
+   the global mutex unless its node already holds it. On unlock, if
+   another thread on the same node is waiting, the global mutex is kept
+   and only the local mutex is released. The protected data then stays in
+   the caches of one node. After max_handoffs consecutive handoffs the
+   global mutex is released so threads on other nodes are not starved.
+   The global mutex is a ticket lock, so a node which releases it queues
+   behind the nodes which are already waiting.
+
+   The Topology must provide node_count() and current_node(). The default
+   reads the NUMA layout on Linux, fake_topology can be used for testing.
+   The timed lock methods poll until the timeout expires.
+*/
+template <typename Topology = linux_topology>
+class cohort_mutex
+{
+   public:
+      explicit cohort_mutex(std::uint32_t max_handoffs = 64, Topology topology = Topology());
+
+      cohort_mutex(const cohort_mutex &) = delete;
+      cohort_mutex &operator=(const cohort_mutex &) = delete;
+
+      void lock();
+      bool try_lock();
+      void unlock();
+
+      template <class Duration>
+      bool try_lock_for(const Duration &duration);
+
+      template <class TimePoint>
+      bool try_lock_until(const TimePoint &timepoint);
+
+   private:
+      struct alignas(64) node_state {
+         adaptive_mutex m_mutex;
+         std::atomic<std::uint32_t> m_waiting = 0;
+
+         // protected by m_mutex
+         bool m_ownsGlobal        = false;
+         std::uint32_t m_handoffs = 0;
+      };
+
+      node_state &current_state();
+
+      void lock_global();
+      bool try_lock_global();
+      void unlock_global();
+
+      Topology m_topology;
+      std::uint32_t m_maxHandoffs;
+
+      std::size_t m_nodeCount;
+      std::unique_ptr<node_state[]> m_nodes;
+
+      // global ticket lock, may be released by a different thread of the node than locked it
+      alignas(64) std::atomic<std::uint32_t> m_nextTicket = 0;
+      std::atomic<std::uint32_t> m_nowServing = 0;
+
+      // only accessed by the thread which owns the mutex
+      node_state *m_owner = nullptr;
+};
+
+// reader-writer mutex whose writers are serialized on a cohort_mutex
+template <typename Topology = linux_topology>
+using cohort_shared_mutex = basic_distributed_shared_mutex<cohort_mutex<Topology>>;
+
+template <typename Topology>
+cohort_mutex<Topology>::cohort_mutex(std::uint32_t max_handoffs, Topology topology)
+   : m_topology(std::move(topology)), m_maxHandoffs(max_handoffs),
+     m_nodeCount(m_topology.node_count()), m_nodes(std::make_unique<node_state[]>(m_nodeCount))
+{
+}
+
+template <typename Topology>
+auto cohort_mutex<Topology>::current_state() -> node_state &
+{
+   return m_nodes[m_topology.current_node() % m_nodeCount];
+}
+
+template <typename Topology>
+void cohort_mutex<Topology>::lock()
+{
+   node_state &node = current_state();
+
+   node.m_waiting.fetch_add(1, std::memory_order_relaxed);
+   node.m_mutex.lock();
+   node.m_waiting.fetch_sub(1, std::memory_order_relaxed);
+
+   if (! node.m_ownsGlobal) {
+      lock_global();
+
+      node.m_ownsGlobal = true;
+      node.m_handoffs   = 0;
+   }
+
+   m_owner = &node;
+}
+
+template <typename Topology>
+bool cohort_mutex<Topology>::try_lock()
+{
+   node_state &node = current_state();
+
+   if (! node.m_mutex.try_lock()) {
+      return false;
+   }
+
+   if (! node.m_ownsGlobal) {
+      if (! try_lock_global()) {
+         node.m_mutex.unlock();
+         return false;
+      }
+
+      node.m_ownsGlobal = true;
+      node.m_handoffs   = 0;
+   }
+
+   m_owner = &node;
+
+   return true;
+}
+
+template <typename Topology>
+void cohort_mutex<Topology>::unlock()
+{
+   node_state &node = *m_owner;
+
+   if (node.m_waiting.load(std::memory_order_relaxed) != 0 && ++node.m_handoffs < m_maxHandoffs) {
+      // pass the mutex to a waiter on the same node, the node keeps the global mutex
+      node.m_mutex.unlock();
+      return;
+   }
+
+   node.m_ownsGlobal = false;
+
+   unlock_global();
+   node.m_mutex.unlock();
+}
+
+template <typename Topology>
+void cohort_mutex<Topology>::lock_global()
+{
+   const std::uint32_t ticket = m_nextTicket.fetch_add(1, std::memory_order_relaxed);
+
+   detail::spin_wait backoff;
+
+   for (;;) {
+      std::uint32_t serving = m_nowServing.load(std::memory_order_acquire);
+
+      if (serving == ticket) {
+         return;
+      }
+
+      if (backoff.is_spinning()) {
+         backoff.wait();
+      } else {
+         m_nowServing.wait(serving, std::memory_order_relaxed);
+      }
+   }
+}
+
+template <typename Topology>
+bool cohort_mutex<Topology>::try_lock_global()
+{
+   std::uint32_t serving = m_nowServing.load(std::memory_order_acquire);
+
+   // only succeeds when no ticket is outstanding
+   return m_nextTicket.compare_exchange_strong(serving, serving + 1, std::memory_order_relaxed);
+}
+
+template <typename Topology>
+void cohort_mutex<Topology>::unlock_global()
+{
+   m_nowServing.fetch_add(1, std::memory_order_release);
+
+   // each waiter holds a different ticket
+   m_nowServing.notify_all();
+}
+
+template <typename Topology>
+template <class Duration>
+bool cohort_mutex<Topology>::try_lock_for(const Duration &duration)
+{
+   return try_lock_until(std::chrono::steady_clock::now() + duration);
+}
+
+template <typename Topology>
+template <class TimePoint>
+bool cohort_mutex<Topology>::try_lock_until(const TimePoint &timepoint)
+{
+   detail::spin_wait backoff;
+
+   while (! try_lock()) {
+      if (TimePoint::clock::now() >= timepoint) {
+         return false;
+      }
+
+      backoff.wait();
+   }
+
+   return true;
+}
+
+}  // namespace libguarded
+
+#endif
@@ -0,0 +1,144 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_COMBINING_GUARDED_H
+#define CSLIBGUARDED_COMBINING_GUARDED_H
+
+#include "cs_operation_slots.h"
+#include "cs_spin_wait.h"
+
+#include <mutex>
+#include <utility>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_combining_guarded.h <CsLibGuarded/cs_combining_guarded.h>
+
+   This templated class wraps an object and allows only one thread at a
+   time to modify it. It is an alternative to plain_guarded for objects
+   where each operation is short, such as counters, queues, and small
+   maps.
+
+   Instead of each thread acquiring the mutex in turn, a thread calling
+   modify() publishes the functor in a slot. Whichever thread holds the
+   mutex runs every published functor in one pass. The protected object
+   stays in the cache of one processor and the cost of passing the mutex
+   between threads is paid once per pass rather than once per operation.
+
+   The functor may run on a different thread than the one which called
+   modify(). The value returned by the functor is returned by modify(),
+   as is any exception it throws. Since modify() always returns after the
+   functor has run, the functor may refer to local variables of the
+   calling thread.
+
+   This class will use std::mutex for the internal locking mechanism by
+   default.
+*/
+template <typename T, typename M = std::mutex>
+class combining_guarded
+{
+   public:
+      /**
+        Construct a guarded object. This constructor will accept any number
+        of parameters, all of which are forwarded to the constructor of T.
+       */
+      template <typename... Us>
+      combining_guarded(Us &&... data);
+
+      combining_guarded(const combining_guarded &) = delete;
+      combining_guarded &operator=(const combining_guarded &) = delete;
+
+      /**
+        Calls func with a reference to the protected object and returns the
+        result by value.
+      */
+      template <typename Func>
+      auto modify(Func &&func);
+
+   private:
+      T m_obj;
+      M m_mutex;
+
+      detail::operation_slots<T> m_slots;
+};
+
+template <typename T, typename M>
+template <typename... Us>
+combining_guarded<T, M>::combining_guarded(Us &&... data)
+   : m_obj(std::forward<Us>(data)...)
+{
+}
+
+template <typename T, typename M>
+template <typename Func>
+auto combining_guarded<T, M>::modify(Func &&func)
+{
+   using operation_slots = detail::operation_slots<T>;
+
+   detail::published_operation<T, std::remove_reference_t<Func>> op(func);
+
+   if (m_mutex.try_lock()) {
+      // uncontended, run the functor directly and then any which were published meanwhile
+      std::lock_guard<M> lock(m_mutex, std::adopt_lock);
+      op.invoke(&op, m_obj);
+
+      if (m_slots.has_pending()) {
+         m_slots.run_pending(m_obj);
+      }
+
+      return op.get();
+   }
+
+   auto *slot = m_slots.claim();
+
+   if (slot == nullptr) {
+      // every slot is in use, run the functor directly
+      std::lock_guard<M> lock(m_mutex);
+      op.invoke(&op, m_obj);
+
+      return op.get();
+   }
+
+   m_slots.publish(*slot, op);
+
+   detail::spin_wait backoff;
+
+   while (! operation_slots::is_done(*slot)) {
+      if (m_mutex.try_lock()) {
+         // runs the functor of this thread as well
+         m_slots.run_pending(m_obj);
+         m_mutex.unlock();
+
+      } else if (backoff.is_spinning()) {
+         backoff.wait();
+
+      } else {
+         std::lock_guard<M> lock(m_mutex);
+         m_slots.run_pending(m_obj);
+      }
+   }
+
+   operation_slots::release(*slot);
+
+   return op.get();
+}
+
+}  // namespace libguarded
+
+#endif
@@ -19,10 +19,17 @@
 #define CSLIBGUARDED_COW_GUARDED_H
 
 #include "cs_lr_guarded.h"
+#include "cs_plain_guarded.h"
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace libguarded
 {
@@ -44,6 +51,25 @@ namespace libguarded
  modified copy and immediately unlock the data without applying the
  changes.
 
+ The lock_lazy() family of methods returns a lazy_handle, which locks
+ the object for writing but does not copy it until the first non-const
+ access. A handle which only reads the data or is cancelled costs no copy
+ and publishes nothing.
+
+ The modify_optimistic() method allows writers to copy and modify the
+ data concurrently. The write mutex is only held briefly to publish the
+ result if no other writer published in the meantime.
+
+ Every published version is assigned a version number, starting from
+ zero for the initial value. Threads can block until a new version is
+ published using wait_for_change(), or register a subscriber which is
+ called with each new version.
+
+ Optionally a bounded number of previous versions can be retained by
+ calling set_history_size(). Retained versions can be read with
+ lock_shared_version() without copying and are released once they fall
+ out of the window.
+
  This class will use std::mutex for the internal locking mechanism by
  default. Other classes which are useful for the mutex type are
  std::recursive_mutex, std::timed_mutex, and
@@ -52,9 +78,14 @@ namespace libguarded
  The handle returned by the various lock methods is moveable but not
  copyable. The shared_handle type is moveable and copyable.
 
+ Each copy of T is created with std::allocate_shared using the Alloc
+ allocator, so the object and its reference count share one
+ allocation. A stateful allocator such as an arena can be passed to the
+ constructor which takes std::allocator_arg as its first argument.
+
  The T class must be copy constructible.
 */
-template <typename T, typename Mutex = std::mutex>
+template <typename T, typename Mutex = std::mutex, typename Alloc = std::allocator<T>>
 class cow_guarded
 {
    private:
@@ -63,7 +94,10 @@ class cow_guarded
 
    public:
       class handle;
-      using shared_handle = std::shared_ptr<const T>;
+      class lazy_handle;
+      using shared_handle  = std::shared_ptr<const T>;
+      using allocator_type = Alloc;
+      using subscriber     = std::function<void(const shared_handle &, std::uint64_t)>;
 
       /**
         Construct a cow_guarded object. This constructor will accept any
@@ -72,6 +106,14 @@ class cow_guarded
       template <typename... Us>
       cow_guarded(Us &&... data);
 
+      /**
+        Construct a cow_guarded object which uses the given allocator for
+        every copy of T. The remaining parameters are forwarded to the
+        constructor of T.
+      */
+      template <typename... Us>
+      cow_guarded(std::allocator_arg_t, Alloc alloc, Us &&... data);
+
       /**
         Acquire a handle to the protected object. As a side effect, the
         protected object will be locked from access by any other
@@ -148,6 +190,123 @@ class cow_guarded
       template <class TimePoint>
       shared_handle try_lock_shared_until(const TimePoint &timepoint) const;
 
+      /**
+        Acquire a lazy_handle to the protected object. The protected object
+        is locked for writing the same as lock(), but the data is only
+        copied when the lazy_handle is first accessed through a non-const
+        method. If no copy was made, releasing the handle does not publish
+        a new version.
+      */
+      [[nodiscard]] lazy_handle lock_lazy();
+
+      /**
+        Attempt to acquire a lazy_handle to the protected object. Returns a
+        null handle if the object is already locked.
+      */
+      [[nodiscard]] lazy_handle try_lock_lazy();
+
+      /**
+        Attempt to acquire a lazy_handle to the protected object. Returns a
+        null handle if the object is already locked, and does not become
+        available for locking before the time duration has elapsed.
+
+        Calling this method requires that the underlying mutex type M
+        supports the try_lock_for method.
+      */
+      template <class Duration>
+      [[nodiscard]] lazy_handle try_lock_lazy_for(const Duration &duration);
+
+      /**
+        Attempt to acquire a lazy_handle to the protected object. Returns a
+        null handle if the object is already locked, and does not become
+        available for locking before reaching the specified timepoint.
+
+        Calling this method requires that the underlying mutex type M
+        supports the try_lock_until method.
+      */
+      template <class TimePoint>
+      [[nodiscard]] lazy_handle try_lock_lazy_until(const TimePoint &timepoint);
+
+      /**
+        Modify the data by passing a functor which takes exactly one argument
+        of type T&. The functor is called on a private copy of the current
+        version without holding the write mutex. The copy is published only
+        if the version it was made from is still current, otherwise a new
+        copy is made from the newer version and the functor is called again.
+
+        The functor may be called more than once and must not have side
+        effects other than modifying its argument. If the functor throws,
+        nothing is published and the exception is propagated.
+      */
+      template <typename Func>
+      void modify_optimistic(Func &&func);
+
+      /**
+        Same as modify_optimistic(func), except when another writer
+        published first the merge functor is called as merge(base, current,
+        modified). The base argument is the version the copy was made from,
+        current is the newer version, and modified is the private copy. If
+        merge returns true, modified is assumed to now include the changes
+        in current and publishing is retried without calling func again. If
+        merge returns false, the copy is discarded and func is called on a
+        copy of current.
+      */
+      template <typename Func, typename Merge>
+      void modify_optimistic(Func &&func, Merge &&merge);
+
+      /**
+        Returns the version number of the most recently published data.
+      */
+      [[nodiscard]] std::uint64_t version() const;
+
+      /**
+        Block until a version other than lastVersion has been published
+        and return the current version. Returns immediately if the current
+        version is already different.
+      */
+      std::uint64_t wait_for_change(std::uint64_t lastVersion) const;
+
+      /**
+        Register a subscriber which will be called with a shared_handle to
+        each newly published version and its version number. Returns an id
+        which can be passed to unsubscribe().
+
+        Subscribers are called on the publishing thread after the write
+        mutex has been released, in the order versions were published. A
+        subscriber may call the lock_shared methods, but must not lock this
+        object for writing and must not call subscribe or unsubscribe.
+        Publishing often happens in a handle destructor, so an exception
+        thrown by a subscriber is discarded and the remaining subscribers
+        are still called.
+      */
+      std::uint64_t subscribe(subscriber func);
+
+      /**
+        Remove the subscriber with the given id. When this method returns
+        the subscriber is not running and will not be called again.
+      */
+      void unsubscribe(std::uint64_t id);
+
+      /**
+        Retain the given number of versions preceding the current version
+        so they can be read using lock_shared_version(). Older versions are
+        released as new versions are published. The default is zero, which
+        retains no history.
+      */
+      void set_history_size(std::size_t count);
+
+      /**
+        Returns the number of previous versions which are retained.
+      */
+      [[nodiscard]] std::size_t history_size() const;
+
+      /**
+        Acquire a shared_handle to the given version of the protected
+        object. Returns a null handle if the version has not been published
+        yet or is no longer retained.
+      */
+      [[nodiscard]] shared_handle lock_shared_version(std::uint64_t version) const;
+
    private:
       class deleter
       {
@@ -156,8 +315,8 @@ class cow_guarded
 
             deleter() = default;
 
-            deleter(std::unique_lock<Mutex> &&lock, cow_guarded &guarded)
-               : m_lock(std::move(lock)), m_guarded(&guarded), m_cancelled(false)
+            deleter(std::unique_lock<Mutex> &&lock, cow_guarded &guarded, std::shared_ptr<T> data)
+               : m_lock(std::move(lock)), m_guarded(&guarded), m_data(std::move(data)), m_cancelled(false)
             {
             }
 
@@ -171,12 +330,10 @@ class cow_guarded
 
             void operator()(T *ptr) {
                if (m_cancelled) {
-                  delete ptr;
+                  m_data.reset();
 
                } else if (ptr && m_guarded) {
-                  std::shared_ptr<const T> newPtr(ptr);
-
-                  m_guarded->m_data.modify([newPtr](std::shared_ptr<const T> &tmpPtr) { tmpPtr = newPtr; });
+                  m_guarded->publish(std::move(m_data), m_lock);
                }
 
                if (m_lock.owns_lock()) {
@@ -186,8 +343,11 @@ class cow_guarded
 
          private:
             std::unique_lock<Mutex> m_lock;
-            cow_guarded *m_guarded;
-            bool m_cancelled;
+            cow_guarded *m_guarded = nullptr;
+
+            // owns the copy, allocated together with its control block
+            std::shared_ptr<T> m_data;
+            bool m_cancelled = false;
       };
 
    public:
@@ -208,32 +368,236 @@ class cow_guarded
             }
       };
 
+      /**
+         Write handle which defers copying the protected object until the
+         first non-const access. Const access reads the version which was
+         current when the handle was acquired. Use std::as_const() or a
+         const reference to inspect the data without making a copy.
+
+         The lazy_handle class is moveable but not copyable.
+      */
+      class lazy_handle
+      {
+         public:
+            lazy_handle() = default;
+
+            lazy_handle(lazy_handle &&other) = default;
+
+            lazy_handle &operator=(lazy_handle &&other) {
+               if (this != &other) {
+                  release();
+
+                  m_lock     = std::move(other.m_lock);
+                  m_guarded  = other.m_guarded;
+                  m_snapshot = std::move(other.m_snapshot);
+                  m_copy     = std::move(other.m_copy);
+               }
+
+               return *this;
+            }
+
+            ~lazy_handle() {
+               release();
+            }
+
+            const T &operator*() const {
+               return *get();
+            }
+
+            const T *operator->() const {
+               return get();
+            }
+
+            T &operator*() {
+               return *access();
+            }
+
+            T *operator->() {
+               return access();
+            }
+
+            /**
+               Returns a pointer to the data without copying it, or nullptr
+               for a null handle.
+            */
+            const T *get() const {
+               if (m_copy != nullptr) {
+                  return m_copy.get();
+               }
+
+               return m_snapshot.get();
+            }
+
+            /**
+               Returns true if the data has been copied and will be published
+               when the handle is released.
+            */
+            bool is_modified() const {
+               return m_copy != nullptr;
+            }
+
+            /**
+               Cancel all pending changes, reset the handle to null, and unlock the data.
+            */
+            void cancel() {
+               m_copy.reset();
+               m_snapshot.reset();
+
+               if (m_lock.owns_lock()) {
+                  m_lock.unlock();
+               }
+            }
+
+            explicit operator bool() const {
+               return m_snapshot != nullptr;
+            }
+
+            bool operator==(std::nullptr_t) const {
+               return m_snapshot == nullptr;
+            }
+
+         private:
+            lazy_handle(std::unique_lock<Mutex> &&lock, cow_guarded &guarded, shared_handle snapshot)
+               : m_lock(std::move(lock)), m_guarded(&guarded), m_snapshot(std::move(snapshot))
+            {
+            }
+
+            T *access() {
+               if (m_copy == nullptr && m_snapshot != nullptr) {
+                  m_copy = std::allocate_shared<T>(m_guarded->m_alloc, *m_snapshot);
+               }
+
+               return m_copy.get();
+            }
+
+            void release() {
+               if (m_lock.owns_lock()) {
+                  if (m_copy != nullptr) {
+                     m_guarded->publish(std::move(m_copy), m_lock);
+                  } else {
+                     m_lock.unlock();
+                  }
+               }
+
+               m_copy.reset();
+               m_snapshot.reset();
+            }
+
+            std::unique_lock<Mutex> m_lock;
+            cow_guarded *m_guarded = nullptr;
+
+            shared_handle m_snapshot;
+            std::shared_ptr<T> m_copy;
+
+            friend class cow_guarded;
+      };
+
    private:
+      handle make_handle(std::unique_lock<Mutex> &&guard);
+      lazy_handle make_lazy_handle(std::unique_lock<Mutex> &&guard);
+
+      // called while the write mutex is held, releases the write mutex
+      void publish(std::shared_ptr<const T> ptr, std::unique_lock<Mutex> &writeLock);
+
+      struct subscriber_list {
+         std::uint64_t m_nextId = 1;
+         std::vector<std::pair<std::uint64_t, subscriber>> m_entries;
+      };
+
+      // oldest version at the front
+      using history_list = std::deque<std::pair<std::uint64_t, shared_handle>>;
+
+      // called while the write mutex is held, the previous version is about to be replaced
+      void record_history();
+
+      Alloc m_alloc;
       mutable lr_guarded<std::shared_ptr<const T>> m_data;
       mutable Mutex m_writeMutex;
+
+      std::atomic<std::uint64_t> m_version = 0;
+
+      std::atomic<std::size_t> m_subscriberCount = 0;
+      plain_guarded<subscriber_list> m_subscribers;
+
+      std::atomic<std::size_t> m_historySize = 0;
+      plain_guarded<history_list> m_history;
 };
 
-template <typename T, typename M>
+template <typename T, typename M, typename A>
 template <typename... Us>
-cow_guarded<T, M>::cow_guarded(Us &&... data)
-   : m_data(std::make_shared<T>(std::forward<Us>(data)...))
+cow_guarded<T, M, A>::cow_guarded(Us &&... data)
+   : m_alloc(), m_data(std::allocate_shared<T>(m_alloc, std::forward<Us>(data)...))
 {
 }
 
-template <typename T, typename M>
-auto cow_guarded<T, M>::lock() -> handle
+template <typename T, typename M, typename A>
+template <typename... Us>
+cow_guarded<T, M, A>::cow_guarded(std::allocator_arg_t, A alloc, Us &&... data)
+   : m_alloc(std::move(alloc)), m_data(std::allocate_shared<T>(m_alloc, std::forward<Us>(data)...))
 {
-   std::unique_lock<M> guard(m_writeMutex);
+}
 
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::make_handle(std::unique_lock<M> &&guard) -> handle
+{
+   // lr_guarded::lock_shared cannot block or fail
    auto data(m_data.lock_shared());
-   std::unique_ptr<T> val(new T(**data));
+
+   std::shared_ptr<T> val(std::allocate_shared<T>(m_alloc, **data));
    data.reset();
 
-   return handle(val.release(), deleter(std::move(guard), *this));
+   T *ptr = val.get();
+
+   return handle(ptr, deleter(std::move(guard), *this, std::move(val)));
+}
+
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::make_lazy_handle(std::unique_lock<M> &&guard) -> lazy_handle
+{
+   // the copy is made on first non-const access
+   return lazy_handle(std::move(guard), *this, lock_shared());
 }
 
-template <typename T, typename M>
-auto cow_guarded<T, M>::try_lock() -> handle
+template <typename T, typename M, typename A>
+void cow_guarded<T, M, A>::publish(std::shared_ptr<const T> ptr, std::unique_lock<M> &writeLock)
+{
+   if (m_historySize.load() != 0) {
+      record_history();
+   }
+
+   std::uint64_t newVersion = m_data.modify([&ptr](std::shared_ptr<const T> &tmpPtr) { tmpPtr = ptr; });
+
+   m_version.store(newVersion);
+   m_version.notify_all();
+
+   if (m_subscriberCount.load() == 0) {
+      writeLock.unlock();
+      return;
+   }
+
+   // acquire the subscriber list before releasing the write mutex so versions are delivered in order
+   auto subscribers = m_subscribers.lock();
+   writeLock.unlock();
+
+   for (auto &item : subscribers->m_entries) {
+      try {
+         item.second(ptr, newVersion);
+      } catch (...) {
+         // publish may be called from a destructor, there is no way to report an exception
+      }
+   }
+}
+
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::lock() -> handle
+{
+   std::unique_lock<M> guard(m_writeMutex);
+
+   return make_handle(std::move(guard));
+}
+
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::try_lock() -> handle
 {
    std::unique_lock<M> guard(m_writeMutex, std::try_to_lock);
 
@@ -241,18 +605,12 @@ auto cow_guarded<T, M>::try_lock() -> handle
       return handle();
    }
 
-   // lr_guarded::lock_shared cannot block or fail
-   auto data(m_data.lock_shared());
-
-   std::unique_ptr<T> val(new T(**data));
-   data.reset();
-
-   return handle(val.release(), deleter(std::move(guard), *this));
+   return make_handle(std::move(guard));
 }
 
-template <typename T, typename M>
+template <typename T, typename M, typename A>
 template <typename Duration>
-auto cow_guarded<T, M>::try_lock_for(const Duration &duration) -> handle
+auto cow_guarded<T, M, A>::try_lock_for(const Duration &duration) -> handle
 {
    std::unique_lock<M> guard(m_writeMutex, duration);
 
@@ -260,18 +618,12 @@ auto cow_guarded<T, M>::try_lock_for(const Duration &duration) -> handle
       return handle();
    }
 
-   // lr_guarded::lock_shared cannot block or fail
-   auto data = m_data.lock_shared();
-
-   std::unique_ptr<T> val(new T(**data));
-   data.reset();
-
-   return handle(val.release(), deleter(std::move(guard), *this));
+   return make_handle(std::move(guard));
 }
 
-template <typename T, typename M>
+template <typename T, typename M, typename A>
 template <typename TimePoint>
-auto cow_guarded<T, M>::try_lock_until(const TimePoint &timepoint) -> handle
+auto cow_guarded<T, M, A>::try_lock_until(const TimePoint &timepoint) -> handle
 {
    std::unique_lock<M> guard(m_writeMutex, timepoint);
 
@@ -279,24 +631,18 @@ auto cow_guarded<T, M>::try_lock_until(const TimePoint &timepoint) -> handle
       return handle();
    }
 
-   // lr_guarded::lock_shared cannot block or fail
-   auto data(m_data.lock_shared());
-
-   std::unique_ptr<T> val(new T(**data));
-   data.reset();
-
-   return handle(val.release(), deleter(std::move(guard), *this));
+   return make_handle(std::move(guard));
 }
 
-template <typename T, typename M>
-auto cow_guarded<T, M>::lock_shared() const -> shared_handle
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::lock_shared() const -> shared_handle
 {
    auto lock = m_data.lock_shared();
    return *lock;
 }
 
-template <typename T, typename M>
-auto cow_guarded<T, M>::try_lock_shared() const -> shared_handle
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::try_lock_shared() const -> shared_handle
 {
    shared_handle retval;
 
@@ -308,9 +654,9 @@ auto cow_guarded<T, M>::try_lock_shared() const -> shared_handle
    return retval;
 }
 
-template <typename T, typename M>
+template <typename T, typename M, typename A>
 template <typename Duration>
-auto cow_guarded<T, M>::try_lock_shared_for(const Duration &duration) const -> shared_handle
+auto cow_guarded<T, M, A>::try_lock_shared_for(const Duration &duration) const -> shared_handle
 {
    shared_handle retval;
 
@@ -322,9 +668,9 @@ auto cow_guarded<T, M>::try_lock_shared_for(const Duration &duration) const -> s
    return retval;
 }
 
-template <typename T, typename M>
+template <typename T, typename M, typename A>
 template <typename TimePoint>
-auto cow_guarded<T, M>::try_lock_shared_until(const TimePoint &timepoint) const -> shared_handle
+auto cow_guarded<T, M, A>::try_lock_shared_until(const TimePoint &timepoint) const -> shared_handle
 {
    shared_handle retval;
 
@@ -336,6 +682,204 @@ auto cow_guarded<T, M>::try_lock_shared_until(const TimePoint &timepoint) const
    return retval;
 }
 
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::lock_lazy() -> lazy_handle
+{
+   std::unique_lock<M> guard(m_writeMutex);
+
+   return make_lazy_handle(std::move(guard));
+}
+
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::try_lock_lazy() -> lazy_handle
+{
+   std::unique_lock<M> guard(m_writeMutex, std::try_to_lock);
+
+   if (! guard.owns_lock()) {
+      return lazy_handle();
+   }
+
+   return make_lazy_handle(std::move(guard));
+}
+
+template <typename T, typename M, typename A>
+template <typename Duration>
+auto cow_guarded<T, M, A>::try_lock_lazy_for(const Duration &duration) -> lazy_handle
+{
+   std::unique_lock<M> guard(m_writeMutex, duration);
+
+   if (! guard.owns_lock()) {
+      return lazy_handle();
+   }
+
+   return make_lazy_handle(std::move(guard));
+}
+
+template <typename T, typename M, typename A>
+template <typename TimePoint>
+auto cow_guarded<T, M, A>::try_lock_lazy_until(const TimePoint &timepoint) -> lazy_handle
+{
+   std::unique_lock<M> guard(m_writeMutex, timepoint);
+
+   if (! guard.owns_lock()) {
+      return lazy_handle();
+   }
+
+   return make_lazy_handle(std::move(guard));
+}
+
+template <typename T, typename M, typename A>
+template <typename Func>
+void cow_guarded<T, M, A>::modify_optimistic(Func &&func)
+{
+   modify_optimistic(std::forward<Func>(func), [](const T &, const T &, T &) { return false; });
+}
+
+template <typename T, typename M, typename A>
+template <typename Func, typename Merge>
+void cow_guarded<T, M, A>::modify_optimistic(Func &&func, Merge &&merge)
+{
+   shared_handle base = lock_shared();
+
+   std::shared_ptr<T> copy = std::allocate_shared<T>(m_alloc, *base);
+   func(*copy);
+
+   while (true) {
+      shared_handle current;
+
+      {
+         std::unique_lock<M> guard(m_writeMutex);
+         current = lock_shared();
+
+         if (current == base) {
+            publish(std::move(copy), guard);
+            return;
+         }
+      }
+
+      if (! merge(std::as_const(*base), std::as_const(*current), *copy)) {
+         copy = std::allocate_shared<T>(m_alloc, *current);
+         func(*copy);
+      }
+
+      base = std::move(current);
+   }
+}
+
+template <typename T, typename M, typename A>
+std::uint64_t cow_guarded<T, M, A>::version() const
+{
+   return m_version.load();
+}
+
+template <typename T, typename M, typename A>
+std::uint64_t cow_guarded<T, M, A>::wait_for_change(std::uint64_t lastVersion) const
+{
+   m_version.wait(lastVersion);
+
+   return m_version.load();
+}
+
+template <typename T, typename M, typename A>
+std::uint64_t cow_guarded<T, M, A>::subscribe(subscriber func)
+{
+   auto subscribers = m_subscribers.lock();
+
+   std::uint64_t id = subscribers->m_nextId;
+   ++subscribers->m_nextId;
+
+   subscribers->m_entries.emplace_back(id, std::move(func));
+   ++m_subscriberCount;
+
+   return id;
+}
+
+template <typename T, typename M, typename A>
+void cow_guarded<T, M, A>::unsubscribe(std::uint64_t id)
+{
+   auto subscribers = m_subscribers.lock();
+   auto &entries    = subscribers->m_entries;
+
+   for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+      if (iter->first == id) {
+         entries.erase(iter);
+         --m_subscriberCount;
+
+         break;
+      }
+   }
+}
+
+template <typename T, typename M, typename A>
+void cow_guarded<T, M, A>::record_history()
+{
+   history_list expired;
+
+   auto current = m_data.lock_shared();
+   std::uint64_t currentVersion = current.get_deleter().version();
+
+   {
+      auto history = m_history.lock();
+      history->emplace_back(currentVersion, *current);
+
+      while (history->size() > m_historySize.load()) {
+         expired.push_back(std::move(history->front()));
+         history->pop_front();
+      }
+   }
+
+   // expired versions are released here, after the history lock
+}
+
+template <typename T, typename M, typename A>
+void cow_guarded<T, M, A>::set_history_size(std::size_t count)
+{
+   history_list expired;
+
+   {
+      auto history = m_history.lock();
+      m_historySize.store(count);
+
+      while (history->size() > count) {
+         expired.push_back(std::move(history->front()));
+         history->pop_front();
+      }
+   }
+}
+
+template <typename T, typename M, typename A>
+std::size_t cow_guarded<T, M, A>::history_size() const
+{
+   return m_historySize.load();
+}
+
+template <typename T, typename M, typename A>
+auto cow_guarded<T, M, A>::lock_shared_version(std::uint64_t version) const -> shared_handle
+{
+   {
+      auto current = m_data.lock_shared();
+      std::uint64_t currentVersion = current.get_deleter().version();
+
+      if (version == currentVersion) {
+         return *current;
+
+      } else if (version > currentVersion) {
+         return shared_handle();
+      }
+   }
+
+   // previous versions are recorded before a newer version is published
+   auto history = m_history.lock();
+
+   for (const auto &item : *history) {
+      if (item.first == version) {
+         return item.second;
+      }
+   }
+
+   return shared_handle();
+}
+
 }  // namespace libguarded
 
 #endif
@@ -0,0 +1,388 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#ifndef CSLIBGUARDED_COW_RCU_GUARDED_H
+#define CSLIBGUARDED_COW_RCU_GUARDED_H
+
+#include "cs_reader_indicator.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace libguarded
+{
+
+/**
+ \headerfile cs_cow_rcu_guarded.h <CsLibGuarded/cs_cow_rcu_guarded.h>
+
+ This templated class provides the same copy on write semantics as
+ cow_guarded. Only one thread at a time may modify the protected
+ object and any number of threads can read it simultaneously.
+
+ Unlike cow_guarded, the current version is published as a raw pointer
+ and readers do not share a reference count. Each reader registers in a
+ per thread counter located on its own cache line, so readers running on
+ different cores do not contend with each other. A writer replaces the
+ pointer and then waits until every reader which may still be using the
+ old version has released its shared_handle before destroying it.
+
+ Since writers wait for readers, a shared_handle should be held only as
+ long as required. Holding a shared_handle while acquiring a handle on
+ the same object from the same thread will deadlock.
+
+ This class will use std::mutex for the internal locking mechanism by
+ default. Other classes which are useful for the mutex type are
+ std::recursive_mutex, std::timed_mutex, and
+ std::recursive_timed_mutex.
+
+ The handle and shared_handle returned by the various lock methods are
+ moveable but not copyable.
+
+ The T class must be copy constructible.
+*/
+template <typename T, typename Mutex = std::mutex>
+class cow_rcu_guarded
+{
+   private:
+      class deleter;
+      class shared_deleter;
+
+   public:
+      class handle;
+      using shared_handle = std::unique_ptr<const T, shared_deleter>;
+
+      /**
+        Construct a cow_rcu_guarded object. This constructor will accept any
+        number of parameters, all of which are forwarded to the constructor of T.
+      */
+      template <typename... Us>
+      cow_rcu_guarded(Us &&... data);
+
+      cow_rcu_guarded(const cow_rcu_guarded &) = delete;
+      cow_rcu_guarded &operator=(const cow_rcu_guarded &) = delete;
+
+      ~cow_rcu_guarded();
+
+      /**
+        Acquire a handle to the protected object. As a side effect, the
+        protected object will be locked from access by any other
+        thread. The lock will be automatically released when the handle
+        is destroyed.
+      */
+      [[nodiscard]] handle lock();
+
+      /**
+        Attempt to acquire a handle to the protected object. Returns a
+        null handle if the object is already locked.
+      */
+      [[nodiscard]] handle try_lock();
+
+      /**
+        Attempt to acquire a handle to the protected object. Returns a
+        null handle if the object is already locked, and does not become
+        available for locking before the time duration has elapsed.
+
+        Calling this method requires that the underlying mutex type M
+        supports the try_lock_for method.  This is not true if M is the
+        default std::mutex.
+      */
+      template <class Duration>
+      [[nodiscard]] handle try_lock_for(const Duration &duration);
+
+      /**
+        Attempt to acquire a handle to the protected object. Returns a
+        null handle if the object is already locked, and does not become
+        available for locking before reaching the specified timepoint.
+
+        Calling this method requires that the underlying mutex type M
+        supports the try_lock_until method.  This is not true if M is the
+        default std::mutex.
+      */
+      template <class TimePoint>
+      [[nodiscard]] handle try_lock_until(const TimePoint &timepoint);
+
+      /**
+        Acquire a shared_handle to the protected object. Always succeeds without
+        blocking.
+      */
+      [[nodiscard]] shared_handle lock_shared() const;
+
+      /**
+        Acquire a shared_handle to the protected object. Always succeeds without
+        blocking.
+      */
+      [[nodiscard]] shared_handle try_lock_shared() const;
+
+      /**
+        Acquire a shared_handle to the protected object. Always succeeds without
+        blocking.
+      */
+      template <class Duration>
+      [[nodiscard]] shared_handle try_lock_shared_for(const Duration &duration) const;
+
+      /**
+        Acquire a shared_handle to the protected object. Always succeeds without
+        blocking.
+      */
+      template <class TimePoint>
+      [[nodiscard]] shared_handle try_lock_shared_until(const TimePoint &timepoint) const;
+
+   private:
+      class deleter
+      {
+         public:
+            using pointer = T *;
+
+            deleter() = default;
+
+            deleter(std::unique_lock<Mutex> &&lock, cow_rcu_guarded &guarded)
+               : m_lock(std::move(lock)), m_guarded(&guarded), m_cancelled(false)
+            {
+            }
+
+            void cancel() {
+               m_cancelled = true;
+
+               if (m_lock.owns_lock()) {
+                  m_lock.unlock();
+               }
+            }
+
+            void operator()(T *ptr) {
+               if (m_cancelled) {
+                  delete ptr;
+
+               } else if (ptr && m_guarded) {
+                  m_guarded->publish(ptr);
+               }
+
+               if (m_lock.owns_lock()) {
+                  m_lock.unlock();
+               }
+            }
+
+         private:
+            std::unique_lock<Mutex> m_lock;
+            cow_rcu_guarded *m_guarded = nullptr;
+            bool m_cancelled = false;
+      };
+
+      class shared_deleter
+      {
+         public:
+            using pointer = const T *;
+
+            shared_deleter() = default;
+
+            shared_deleter(std::atomic<int> &readingCount)
+               : m_readingCount(&readingCount)
+            {
+            }
+
+            shared_deleter(shared_deleter &&other)
+               : m_readingCount(other.m_readingCount)
+            {
+               other.m_readingCount = nullptr;
+            }
+
+            shared_deleter &operator=(shared_deleter &&other) {
+               m_readingCount = other.m_readingCount;
+               other.m_readingCount = nullptr;
+
+               return *this;
+            }
+
+            void operator()(const T *ptr) {
+               if (ptr && m_readingCount) {
+                  detail::reader_indicator::depart(*m_readingCount);
+               }
+            }
+
+         private:
+            std::atomic<int> *m_readingCount = nullptr;
+      };
+
+   public:
+      /**
+         The handle class for cow_rcu_guarded is moveable but not copyable.
+      */
+      class handle : public std::unique_ptr<T, deleter>
+      {
+         public:
+            using std::unique_ptr<T, deleter>::unique_ptr;
+
+            /**
+               Cancel all pending changes, reset the handle to null, and unlock the data.
+            */
+            void cancel() {
+               this->get_deleter().cancel();
+               this->reset();
+            }
+      };
+
+   private:
+      handle make_handle(std::unique_lock<Mutex> &&guard);
+
+      // called by the deleter while the write mutex is held
+      void publish(T *ptr);
+
+      static void wait_for_readers(const detail::reader_indicator &readers);
+
+      std::atomic<const T *> m_current;
+
+      std::atomic<bool> m_countingLeft;
+      mutable detail::reader_indicator m_leftReaders;
+      mutable detail::reader_indicator m_rightReaders;
+
+      mutable Mutex m_writeMutex;
+};
+
+template <typename T, typename M>
+template <typename... Us>
+cow_rcu_guarded<T, M>::cow_rcu_guarded(Us &&... data)
+   : m_current(new T(std::forward<Us>(data)...)), m_countingLeft(true)
+{
+}
+
+template <typename T, typename M>
+cow_rcu_guarded<T, M>::~cow_rcu_guarded()
+{
+   delete m_current.load();
+}
+
+template <typename T, typename M>
+auto cow_rcu_guarded<T, M>::make_handle(std::unique_lock<M> &&guard) -> handle
+{
+   // only writers replace m_current and the write mutex is held
+   std::unique_ptr<T> val(new T(*m_current.load()));
+
+   return handle(val.release(), deleter(std::move(guard), *this));
+}
+
+template <typename T, typename M>
+auto cow_rcu_guarded<T, M>::lock() -> handle
+{
+   std::unique_lock<M> guard(m_writeMutex);
+
+   return make_handle(std::move(guard));
+}
+
+template <typename T, typename M>
+auto cow_rcu_guarded<T, M>::try_lock() -> handle
+{
+   std::unique_lock<M> guard(m_writeMutex, std::try_to_lock);
+
+   if (! guard.owns_lock()) {
+      return handle();
+   }
+
+   return make_handle(std::move(guard));
+}
+
+template <typename T, typename M>
+template <typename Duration>
+auto cow_rcu_guarded<T, M>::try_lock_for(const Duration &duration) -> handle
+{
+   std::unique_lock<M> guard(m_writeMutex, duration);
+
+   if (! guard.owns_lock()) {
+      return handle();
+   }
+
+   return make_handle(std::move(guard));
+}
+
+template <typename T, typename M>
+template <typename TimePoint>
+auto cow_rcu_guarded<T, M>::try_lock_until(const TimePoint &timepoint) -> handle
+{
+   std::unique_lock<M> guard(m_writeMutex, timepoint);
+
+   if (! guard.owns_lock()) {
+      return handle();
+   }
+
+   return make_handle(std::move(guard));
+}
+
+template <typename T, typename M>
+void cow_rcu_guarded<T, M>::wait_for_readers(const detail::reader_indicator &readers)
+{
+   while (! readers.empty()) {
+      std::this_thread::yield();
+   }
+}
+
+template <typename T, typename M>
+void cow_rcu_guarded<T, M>::publish(T *ptr)
+{
+   const T *oldPtr = m_current.exchange(ptr);
+
+   // same two phase wait as lr_guarded, afterwards no reader can hold oldPtr
+   bool local_countingLeft = m_countingLeft.load();
+
+   if (local_countingLeft) {
+      wait_for_readers(m_rightReaders);
+   } else {
+      wait_for_readers(m_leftReaders);
+   }
+
+   m_countingLeft.store(! local_countingLeft);
+
+   if (local_countingLeft) {
+      wait_for_readers(m_leftReaders);
+   } else {
+      wait_for_readers(m_rightReaders);
+   }
+
+   delete oldPtr;
+}
+
+template <typename T, typename M>
+auto cow_rcu_guarded<T, M>::lock_shared() const -> shared_handle
+{
+   std::atomic<int> &readingCount = m_countingLeft.load() ? m_leftReaders.arrive() : m_rightReaders.arrive();
+
+   return shared_handle(m_current.load(), shared_deleter(readingCount));
+}
+
+template <typename T, typename M>
+auto cow_rcu_guarded<T, M>::try_lock_shared() const -> shared_handle
+{
+   return lock_shared();
+}
+
+template <typename T, typename M>
+template <typename Duration>
+auto cow_rcu_guarded<T, M>::try_lock_shared_for(const Duration &) const -> shared_handle
+{
+   return lock_shared();
+}
+
+template <typename T, typename M>
+template <typename TimePoint>
+auto cow_rcu_guarded<T, M>::try_lock_shared_until(const TimePoint &) const -> shared_handle
+{
+   return lock_shared();
+}
+
+}  // namespace libguarded
+
+#endif
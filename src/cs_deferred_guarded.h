@@ -21,17 +21,238 @@
 #include "cs_plain_guarded.h"
 
 #include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <future>
 #include <memory>
-#include <vector>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 namespace libguarded
 {
 
+namespace detail
+{
+
+/**
+   Intrusive multiple producer, single consumer queue. The Node type must
+   be default constructible and have a member m_next of type
+   std::atomic<Node *>.
+
+   Pushing is wait-free and can be done by any thread. Only one thread at a
+   time may call pop(), the caller is responsible for providing this
+   exclusion. If a producer has been interrupted in the middle of a push,
+   pop() may return nullptr even though later nodes have been pushed. The
+   remaining nodes become visible once that push completes.
+*/
+template <typename Node>
+class mpsc_queue
+{
+   public:
+      mpsc_queue()
+         : m_head(&m_stub), m_tail(&m_stub)
+      {
+      }
+
+      mpsc_queue(const mpsc_queue &) = delete;
+      mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+      void push(Node *node) {
+         node->m_next.store(nullptr, std::memory_order_relaxed);
+
+         Node *prev = m_tail.exchange(node, std::memory_order_acq_rel);
+         prev->m_next.store(node, std::memory_order_release);
+      }
+
+      Node *pop() {
+         Node *head = m_head;
+         Node *next = head->m_next.load(std::memory_order_acquire);
+
+         if (head == &m_stub) {
+            if (next == nullptr) {
+               return nullptr;
+            }
+
+            m_head = next;
+            head   = next;
+            next   = next->m_next.load(std::memory_order_acquire);
+         }
+
+         if (next != nullptr) {
+            m_head = next;
+            return head;
+         }
+
+         if (m_tail.load(std::memory_order_acquire) != head) {
+            // a push is in progress
+            return nullptr;
+         }
+
+         // head is the last node, requeue the stub so head can be detached
+         push(&m_stub);
+
+         next = head->m_next.load(std::memory_order_acquire);
+
+         if (next != nullptr) {
+            m_head = next;
+            return head;
+         }
+
+         return nullptr;
+      }
+
+   private:
+      Node m_stub;
+      Node *m_head;
+
+      alignas(64) std::atomic<Node *> m_tail;
+};
+
+/**
+   Move only type erased callable with inline storage. Callables which fit
+   in Size bytes and are nothrow move constructible are stored in place,
+   larger callables are allocated on the heap.
+*/
+template <typename Signature, std::size_t Size = 64>
+class small_task;
+
+template <typename R, typename... Args, std::size_t Size>
+class small_task<R(Args...), Size>
+{
+   public:
+      small_task() = default;
+
+      template <typename F, typename = std::enable_if_t<! std::is_same_v<std::decay_t<F>, small_task>>>
+      small_task(F &&func) {
+         using stored_type = std::decay_t<F>;
+
+         if constexpr (fits_inline<stored_type>) {
+            ::new (static_cast<void *>(m_storage)) stored_type(std::forward<F>(func));
+            m_vtable = &inline_vtable<stored_type>;
+
+         } else {
+            ::new (static_cast<void *>(m_storage)) stored_type *(new stored_type(std::forward<F>(func)));
+            m_vtable = &heap_vtable<stored_type>;
+         }
+      }
+
+      small_task(const small_task &) = delete;
+      small_task &operator=(const small_task &) = delete;
+
+      small_task(small_task &&other) noexcept {
+         if (other.m_vtable != nullptr) {
+            other.m_vtable->move(m_storage, other.m_storage);
+            m_vtable = other.m_vtable;
+
+            other.reset();
+         }
+      }
+
+      small_task &operator=(small_task &&other) noexcept {
+         if (this != &other) {
+            reset();
+
+            if (other.m_vtable != nullptr) {
+               other.m_vtable->move(m_storage, other.m_storage);
+               m_vtable = other.m_vtable;
+
+               other.reset();
+            }
+         }
+
+         return *this;
+      }
+
+      ~small_task() {
+         reset();
+      }
+
+      R operator()(Args... args) {
+         return m_vtable->invoke(m_storage, std::forward<Args>(args)...);
+      }
+
+      explicit operator bool() const {
+         return m_vtable != nullptr;
+      }
+
+   private:
+      struct vtable_type {
+         R (*invoke)(void *storage, Args &&... args);
+         void (*move)(void *dst, void *src) noexcept;
+         void (*destroy)(void *storage) noexcept;
+      };
+
+      template <typename F>
+      static constexpr bool fits_inline = sizeof(F) <= Size && alignof(F) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<F>;
+
+      template <typename F>
+      static constexpr vtable_type inline_vtable = {
+         [](void *storage, Args &&... args) -> R {
+            return (*static_cast<F *>(storage))(std::forward<Args>(args)...);
+         },
+         [](void *dst, void *src) noexcept {
+            ::new (dst) F(std::move(*static_cast<F *>(src)));
+         },
+         [](void *storage) noexcept {
+            static_cast<F *>(storage)->~F();
+         }
+      };
+
+      template <typename F>
+      static constexpr vtable_type heap_vtable = {
+         [](void *storage, Args &&... args) -> R {
+            return (**static_cast<F **>(storage))(std::forward<Args>(args)...);
+         },
+         [](void *dst, void *src) noexcept {
+            ::new (dst) F *(*static_cast<F **>(src));
+            *static_cast<F **>(src) = nullptr;
+         },
+         [](void *storage) noexcept {
+            delete *static_cast<F **>(storage);
+         }
+      };
+
+      void reset() {
+         if (m_vtable != nullptr) {
+            m_vtable->destroy(m_storage);
+            m_vtable = nullptr;
+         }
+      }
+
+      alignas(std::max_align_t) unsigned char m_storage[Size];
+      const vtable_type *m_vtable = nullptr;
+};
+
+}  // namespace detail
+
 template <class T>
 typename std::add_lvalue_reference<T>::type declref();
 
+/**
+   Stored in the future returned by deferred_guarded::modify_async() when
+   the pending queue is full and the overflow policy is reject.
+*/
+class pending_limit_exceeded : public std::runtime_error
+{
+   public:
+      pending_limit_exceeded()
+         : std::runtime_error("deferred_guarded pending write limit exceeded")
+      {
+      }
+};
+
 /**
    \headerfile cs_deferred_guarded.h <CsLibGuarded/cs_deferred_guarded.h>
 
@@ -42,6 +263,47 @@ typename std::add_lvalue_reference<T>::type declref();
    This class will use std::shared_timed_mutex for the internal locking mechanism by
    default. In C++17, the class std::shared_mutex is available as well.
 
+   Modifications which can not be applied immediately are pushed onto a
+   lock-free queue and applied in order by the next thread which obtains
+   exclusive access. Each queued modification requires a single allocation
+   unless its functor is larger than 64 bytes. Exceptions thrown by a
+   functor passed to modify_detach() are discarded.
+
+   By default queued modifications are applied by whichever thread next
+   acquires a lock, which may be a reader. Calling set_executor() or
+   start_drain_thread() moves this work off the read path, readers will
+   then never run a queued modification. The executor should run every
+   job it is given, while a job is outstanding no other job is submitted.
+   A job which runs after the deferred_guarded was destroyed, or which is
+   discarded by the executor, does nothing. The executor may run a job
+   inline. A job which finds the lock held returns at once, and the thread
+   which releases the lock submits the next job.
+
+   Modifications submitted with a key replace any queued modification with
+   the same key which has not started running. The replacement runs at the
+   position of the modification it replaced.
+
+   The number of queued modifications can be limited by calling
+   set_pending_limit(). When the queue is full the overflow policy decides
+   whether the caller waits for room, applies the modification itself
+   after blocking on the lock, or has the modification rejected. Waiting
+   for room requires an executor or drain thread, without one the block
+   policy behaves as apply_synchronously.
+
+   The awaitable returned by co_modify() queues the modification without
+   allocating and resumes the awaiting coroutine once it has been applied.
+   The coroutine is resumed by the thread which applied the modification,
+   after the lock has been released. A coroutine suspended when the
+   deferred_guarded is destroyed is never resumed.
+
+   A steady stream of readers can prevent queued modifications from ever
+   obtaining exclusive access. Calling set_fairness() bounds how many
+   modifications may be queued, or how long the oldest may wait, before
+   lock_shared() closes a gate to new readers until the queue has been
+   drained. A thread which already holds a shared_handle must not call
+   lock_shared() while fairness is enabled. The try_lock_shared methods
+   never wait at the gate.
+
    The shared_handle returned by the various lock methods is moveable
    but not copyable.
 */
@@ -57,13 +319,57 @@ class deferred_guarded
       template <typename... Us>
       deferred_guarded(Us &&... data);
 
+      deferred_guarded(const deferred_guarded &) = delete;
+      deferred_guarded &operator=(const deferred_guarded &) = delete;
+
+      ~deferred_guarded();
+
+      using executor_type = std::function<void(std::function<void()>)>;
+
+      enum class overflow_policy {
+         block,
+         apply_synchronously,
+         reject
+      };
+
+      struct pending_stats {
+         std::size_t depth;
+         std::size_t high_water_mark;
+         std::uint64_t drain_count;
+         std::chrono::nanoseconds drain_time;
+      };
+
+      // not thread safe, must not be called concurrently with any other method
+      void set_executor(executor_type executor);
+      void start_drain_thread();
+      void stop_drain_thread();
+
+      // a limit of zero allows an unbounded number of queued modifications
+      void set_pending_limit(std::size_t limit, overflow_policy policy = overflow_policy::block);
+
+      // zero disables the corresponding limit
+      void set_fairness(std::size_t max_pending,
+            std::chrono::nanoseconds max_staleness = std::chrono::nanoseconds::zero());
+
+      [[nodiscard]] pending_stats stats() const;
+
+      // returns false if the modification was rejected
       template <typename Func>
-      void modify_detach(Func && func);
+      bool modify_detach(Func && func);
+
+      template <typename Func>
+      bool modify_detach(std::size_t key, Func && func);
 
       template <typename Func>
       [[nodiscard]] auto modify_async(Func && func) ->
          typename std::future<decltype(std::declval<Func>()(declref<T>()))>;
 
+      template <typename Func>
+      class modify_awaiter;
+
+      template <typename Func>
+      [[nodiscard]] modify_awaiter<std::decay_t<Func>> co_modify(Func && func);
+
       [[nodiscard]] shared_handle lock_shared() const;
       [[nodiscard]] shared_handle try_lock_shared() const;
 
@@ -79,63 +385,607 @@ class deferred_guarded
          public:
             using pointer = const T *;
 
-            shared_deleter(M & mutex)
-               : m_deleter_mutex(mutex)
+            shared_deleter(const deferred_guarded & guarded)
+               : m_guarded(guarded)
             {
             }
 
             void operator()(const T * ptr)
             {
                if (ptr) {
-                  m_deleter_mutex.unlock_shared();
+                  m_guarded.m_mutex.unlock_shared();
+                  m_guarded.drain_after_release();
                }
             }
 
          private:
-            M & m_deleter_mutex;
+            const deferred_guarded & m_guarded;
+      };
+
+      // submits a drain job for writes queued while the lock was held, runs after the lock is released
+      class release_notifier
+      {
+         public:
+            explicit release_notifier(const deferred_guarded & guarded)
+               : m_guarded(guarded)
+            {
+            }
+
+            release_notifier(const release_notifier &) = delete;
+            release_notifier &operator=(const release_notifier &) = delete;
+
+            ~release_notifier()
+            {
+               m_guarded.drain_after_release();
+            }
+
+         private:
+            const deferred_guarded & m_guarded;
+      };
+
+      using task_type = detail::small_task<void(T &)>;
+
+      struct pending_node {
+         std::atomic<pending_node *> m_next = nullptr;
+         task_type m_task;
+
+         bool m_keyed      = false;
+         std::size_t m_key = 0;
+
+         // set for nodes embedded in a modify_awaiter, these are not heap allocated
+         std::coroutine_handle<> m_continuation;
+         pending_node *m_nextReady = nullptr;
+      };
+
+      // declare before the lock, coroutines are resumed after the lock is released
+      class resume_list
+      {
+         public:
+            resume_list() = default;
+
+            resume_list(const resume_list &) = delete;
+            resume_list &operator=(const resume_list &) = delete;
+
+            ~resume_list()
+            {
+               while (m_head != nullptr) {
+                  pending_node *node = m_head;
+                  m_head = node->m_nextReady;
+
+                  // node is destroyed by the coroutine
+                  node->m_continuation.resume();
+               }
+            }
+
+            void push(pending_node *node)
+            {
+               if (m_head == nullptr) {
+                  m_head = node;
+               } else {
+                  m_tail->m_nextReady = node;
+               }
+
+               m_tail = node;
+            }
+
+         private:
+            pending_node *m_head = nullptr;
+            pending_node *m_tail = nullptr;
       };
 
       void do_pending_writes() const;
 
+      // blocks while the reader gate is closed, closes it if the fairness limits are exceeded
+      void enforce_fairness() const;
+      bool fairness_exceeded() const;
+
+      // requires exclusive ownership of m_mutex
+      void drain_pending_writes(resume_list & ready) const;
+
+      void push_pending_write(task_type task);
+      void push_pending_node(pending_node *node);
+
+      // returns false if the queue is full and the caller must apply the overflow policy
+      bool acquire_pending_slot();
+      void release_pending_slot();
+
+      void schedule_drain() const;
+      void run_drain_job();
+
+      // must be called after releasing m_mutex when it may have blocked a drain job
+      void drain_after_release() const;
+
+      enum class drain_mode {
+         inline_drain,
+         executor_drain,
+         thread_drain
+      };
+
       mutable T m_obj;
       mutable M m_mutex;
 
       mutable std::atomic<bool>  m_pendingWrites;
 
-      mutable plain_guarded<std::vector<std::packaged_task<void(T &)>>> m_pendingList;
+      mutable detail::mpsc_queue<pending_node> m_pendingList;
+
+      std::size_t m_pendingLimit      = 0;
+      overflow_policy m_overflowPolicy = overflow_policy::block;
+
+      mutable std::atomic<std::size_t> m_pendingCount   = 0;
+      std::atomic<std::size_t>         m_highWaterMark  = 0;
+      mutable std::atomic<std::uint64_t> m_drainCount   = 0;
+      mutable std::atomic<std::int64_t>  m_drainTime    = 0;
+
+      std::size_t m_fairPending = 0;
+      std::chrono::nanoseconds m_fairStaleness = std::chrono::nanoseconds::zero();
+
+      mutable std::atomic<bool> m_readerGate            = false;
+      mutable std::atomic<std::int64_t> m_oldestPending = 0;
+
+      // keyed nodes which are queued and have not been claimed by a drain
+      mutable plain_guarded<std::unordered_map<std::size_t, pending_node *>> m_keyedNodes;
+
+      drain_mode m_drainMode = drain_mode::inline_drain;
+
+      // shared with submitted drain jobs, which may outlive this object
+      struct drain_token {
+         explicit drain_token(deferred_guarded *guarded)
+            : m_guarded(guarded)
+         {
+         }
+
+         std::mutex m_mutex;
+         deferred_guarded *m_guarded;
+      };
+
+      executor_type m_executor;
+      mutable std::atomic<bool> m_drainScheduled = false;
+      mutable std::atomic<std::uint64_t> m_releaseCount = 0;
+      std::shared_ptr<drain_token> m_drainToken;
+
+      std::atomic<bool> m_drainStop      = false;
+      std::thread       m_drainThread;
 };
 
 template <typename T, typename M>
 template <typename... Us>
 deferred_guarded<T, M>::deferred_guarded(Us &&... data)
-   : m_obj(std::forward<Us>(data)...), m_pendingWrites(false)
+   : m_obj(std::forward<Us>(data)...), m_pendingWrites(false),
+     m_drainToken(std::make_shared<drain_token>(this))
 {
 }
 
+template <typename T, typename M>
+deferred_guarded<T, M>::~deferred_guarded()
+{
+   stop_drain_thread();
+
+   {
+      // waits for a running drain job, jobs which have not started will do nothing
+      std::lock_guard<std::mutex> lock(m_drainToken->m_mutex);
+      m_drainToken->m_guarded = nullptr;
+   }
+
+   // writes which were never applied are discarded
+   while (pending_node *node = m_pendingList.pop()) {
+      if (! node->m_continuation) {
+         delete node;
+      }
+   }
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::drain_pending_writes(resume_list & ready) const
+{
+   auto start = std::chrono::steady_clock::now();
+   std::size_t count = 0;
+
+   // consider looser memory ordering
+   m_pendingWrites.store(false);
+   m_oldestPending.store(0);
+
+   while (pending_node *node = m_pendingList.pop()) {
+      ++count;
+
+      std::unique_ptr<pending_node> owner(node->m_continuation ? nullptr : node);
+
+      if (node->m_keyed) {
+         // once erased no writer can replace the task
+         m_keyedNodes.lock()->erase(node->m_key);
+      }
+
+      try {
+         node->m_task(m_obj);
+      } catch (...) {
+         // modify_detach has no way to report an exception, modify_async tasks never throw
+      }
+
+      if (node->m_continuation) {
+         ready.push(node);
+      }
+   }
+
+   if (count != 0) {
+      m_pendingCount.fetch_sub(count);
+      m_pendingCount.notify_all();
+   }
+
+   if (m_readerGate.load()) {
+      m_readerGate.store(false);
+      m_readerGate.notify_all();
+   }
+
+   auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+   m_drainCount.fetch_add(1, std::memory_order_relaxed);
+   m_drainTime.fetch_add(elapsed.count(), std::memory_order_relaxed);
+}
+
+template <typename T, typename M>
+bool deferred_guarded<T, M>::acquire_pending_slot()
+{
+   std::size_t count = m_pendingCount.load();
+
+   while (true) {
+      if (m_pendingLimit != 0 && count >= m_pendingLimit) {
+         if (m_overflowPolicy != overflow_policy::block || m_drainMode == drain_mode::inline_drain) {
+            return false;
+         }
+
+         // woken by the next drain
+         m_pendingCount.wait(count);
+         count = m_pendingCount.load();
+
+         continue;
+      }
+
+      if (m_pendingCount.compare_exchange_weak(count, count + 1)) {
+         break;
+      }
+   }
+
+   std::size_t highWater = m_highWaterMark.load(std::memory_order_relaxed);
+
+   while (count + 1 > highWater &&
+         ! m_highWaterMark.compare_exchange_weak(highWater, count + 1, std::memory_order_relaxed)) {
+   }
+
+   return true;
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::release_pending_slot()
+{
+   m_pendingCount.fetch_sub(1);
+   m_pendingCount.notify_all();
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::set_pending_limit(std::size_t limit, overflow_policy policy)
+{
+   m_pendingLimit   = limit;
+   m_overflowPolicy = policy;
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::set_fairness(std::size_t max_pending, std::chrono::nanoseconds max_staleness)
+{
+   m_fairPending   = max_pending;
+   m_fairStaleness = max_staleness;
+}
+
+template <typename T, typename M>
+bool deferred_guarded<T, M>::fairness_exceeded() const
+{
+   if (m_fairPending != 0 && m_pendingCount.load() >= m_fairPending) {
+      return true;
+   }
+
+   if (m_fairStaleness != std::chrono::nanoseconds::zero()) {
+      std::int64_t oldest = m_oldestPending.load();
+
+      if (oldest != 0) {
+         auto now = std::chrono::steady_clock::now().time_since_epoch();
+         return now - std::chrono::steady_clock::duration(oldest) >= m_fairStaleness;
+      }
+   }
+
+   return false;
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::enforce_fairness() const
+{
+   while (true) {
+      if (m_readerGate.load()) {
+         m_readerGate.wait(true);
+         continue;
+      }
+
+      if (! m_pendingWrites.load() || ! fairness_exceeded()) {
+         return;
+      }
+
+      if (m_readerGate.exchange(true)) {
+         // closed by another reader
+         continue;
+      }
+
+      if (m_drainMode == drain_mode::inline_drain) {
+         // readers already holding a lock finish, then this thread drains and opens the gate
+         resume_list ready;
+         std::unique_lock<M> lock(m_mutex);
+
+         drain_pending_writes(ready);
+         return;
+      }
+
+      if (! m_pendingWrites.load()) {
+         // the queue was drained before the gate closed, no drain is scheduled to open it
+         m_readerGate.store(false);
+         m_readerGate.notify_all();
+      }
+
+      // otherwise the executor or drain thread opens the gate
+   }
+}
+
+template <typename T, typename M>
+auto deferred_guarded<T, M>::stats() const -> pending_stats
+{
+   return pending_stats{m_pendingCount.load(), m_highWaterMark.load(), m_drainCount.load(),
+         std::chrono::nanoseconds(m_drainTime.load())};
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::push_pending_write(task_type task)
+{
+   auto node = std::make_unique<pending_node>();
+   node->m_task = std::move(task);
+
+   push_pending_node(node.release());
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::push_pending_node(pending_node *node)
+{
+   if (m_fairStaleness != std::chrono::nanoseconds::zero() && m_oldestPending.load() == 0) {
+      std::int64_t expected = 0;
+      m_oldestPending.compare_exchange_strong(expected,
+            std::chrono::steady_clock::now().time_since_epoch().count());
+   }
+
+   m_pendingList.push(node);
+   m_pendingWrites.store(true);
+
+   if (m_drainMode == drain_mode::executor_drain) {
+      schedule_drain();
+
+   } else if (m_drainMode == drain_mode::thread_drain) {
+      m_pendingWrites.notify_one();
+   }
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::set_executor(executor_type executor)
+{
+   stop_drain_thread();
+
+   m_executor  = std::move(executor);
+   m_drainMode = m_executor ? drain_mode::executor_drain : drain_mode::inline_drain;
+
+   if (m_drainMode == drain_mode::executor_drain && m_pendingWrites.load()) {
+      schedule_drain();
+   }
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::start_drain_thread()
+{
+   if (m_drainMode == drain_mode::thread_drain) {
+      return;
+   }
+
+   m_executor  = nullptr;
+   m_drainMode = drain_mode::thread_drain;
+
+   m_drainStop.store(false);
+
+   m_drainThread = std::thread([this]() {
+      // checked before every wait, otherwise a drain which clears m_pendingWrites
+      // after stop_drain_thread() sets it would leave this thread blocked
+      while (! m_drainStop.load()) {
+         m_pendingWrites.wait(false);
+
+         if (m_drainStop.load()) {
+            break;
+         }
+
+         resume_list ready;
+         std::unique_lock<M> lock(m_mutex);
+
+         if (m_pendingWrites.load()) {
+            drain_pending_writes(ready);
+         }
+      }
+   });
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::stop_drain_thread()
+{
+   if (m_drainMode != drain_mode::thread_drain) {
+      return;
+   }
+
+   m_drainStop.store(true);
+
+   // wake the drain thread, any writes still queued are applied inline by the next lock
+   m_pendingWrites.store(true);
+   m_pendingWrites.notify_one();
+
+   m_drainThread.join();
+
+   m_drainMode = drain_mode::inline_drain;
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::schedule_drain() const
+{
+   if (m_drainScheduled.exchange(true)) {
+      // a drain job is already queued or running and will see this write
+      return;
+   }
+
+   m_executor([token = m_drainToken]() {
+      std::lock_guard<std::mutex> lock(token->m_mutex);
+
+      if (token->m_guarded != nullptr) {
+         token->m_guarded->run_drain_job();
+      }
+   });
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::run_drain_job()
+{
+   while (true) {
+      std::uint64_t releases = m_releaseCount.load();
+      bool drained = false;
+
+      {
+         resume_list ready;
+
+         // the executor may run this job inline on a thread which holds the lock
+         std::unique_lock<M> lock(m_mutex, std::try_to_lock);
+
+         if (lock.owns_lock()) {
+            drain_pending_writes(ready);
+            drained = true;
+         }
+      }
+
+      m_drainScheduled.store(false);
+
+      if (! drained && m_releaseCount.load() == releases) {
+         // the thread holding the lock will see m_drainScheduled as false when it releases the lock
+         return;
+      }
+
+      // a write pushed after the drain, or a release before m_drainScheduled was cleared, may have been missed
+      if (! m_pendingWrites.load() || m_drainScheduled.exchange(true)) {
+         return;
+      }
+   }
+}
+
+template <typename T, typename M>
+void deferred_guarded<T, M>::drain_after_release() const
+{
+   if (m_drainMode != drain_mode::executor_drain) {
+      return;
+   }
+
+   ++m_releaseCount;
+
+   if (m_pendingWrites.load()) {
+      schedule_drain();
+   }
+}
+
+template <typename T, typename M>
+template <typename Func>
+bool deferred_guarded<T, M>::modify_detach(Func && func)
+{
+   release_notifier notifier(*this);
+   resume_list ready;
+   std::unique_lock<M> lock(m_mutex, std::try_to_lock);
+
+   if (! lock.owns_lock()) {
+      if (acquire_pending_slot()) {
+         push_pending_write(task_type(std::forward<Func>(func)));
+         return true;
+      }
+
+      if (m_overflowPolicy == overflow_policy::reject) {
+         return false;
+      }
+
+      lock.lock();
+   }
+
+   if (m_pendingWrites.load()) {
+      drain_pending_writes(ready);
+   }
+
+   func(m_obj);
+
+   return true;
+}
+
 template <typename T, typename M>
 template <typename Func>
-void deferred_guarded<T, M>::modify_detach(Func && func)
+bool deferred_guarded<T, M>::modify_detach(std::size_t key, Func && func)
 {
+   release_notifier notifier(*this);
+   resume_list ready;
    std::unique_lock<M> lock(m_mutex, std::try_to_lock);
 
-   if (lock.owns_lock()) {
-      // consider looser memory ordering
-      if (m_pendingWrites.load()) {
-         std::vector<std::packaged_task<void(T &)>> localPending;
-         m_pendingWrites.store(false);
-         swap(localPending, *(m_pendingList.lock()));
+   if (! lock.owns_lock()) {
+      {
+         auto keyedNodes = m_keyedNodes.lock();
+         auto iter       = keyedNodes->find(key);
 
-         for (auto & f : localPending) {
-            f(m_obj);
+         if (iter != keyedNodes->end()) {
+            // node is still queued, the previous task is discarded and no slot is needed
+            iter->second->m_task = task_type(std::forward<Func>(func));
+            return true;
          }
       }
 
-      func(m_obj);
+      // a drain may need m_keyedNodes to make room, reserve before locking it
+      if (acquire_pending_slot()) {
+         task_type task(std::forward<Func>(func));
 
-   } else {
-      m_pendingList.lock()->push_back(std::packaged_task<void(T &)>(std::forward<Func>(func)));
-      m_pendingWrites.store(true);
+         auto keyedNodes = m_keyedNodes.lock();
+         auto iter       = keyedNodes->find(key);
+
+         if (iter != keyedNodes->end()) {
+            // queued by another writer while the slot was reserved
+            iter->second->m_task = std::move(task);
+
+            keyedNodes.reset();
+            release_pending_slot();
+
+            return true;
+         }
+
+         auto node = std::make_unique<pending_node>();
+         node->m_task  = std::move(task);
+         node->m_keyed = true;
+         node->m_key   = key;
+
+         keyedNodes->emplace(key, node.get());
+         keyedNodes.reset();
+
+         push_pending_node(node.release());
+         return true;
+      }
+
+      if (m_overflowPolicy == overflow_policy::reject) {
+         return false;
+      }
+
+      lock.lock();
    }
+
+   if (m_pendingWrites.load()) {
+      drain_pending_writes(ready);
+   }
+
+   func(m_obj);
+
+   return true;
 }
 
 template <typename Ret, typename Func, typename T>
@@ -169,26 +1019,21 @@ auto call_returning_future(Func & func, T & data) ->
    return promise.get_future();
 }
 
-template <typename Ret, typename T, typename Func>
-auto package_task_void(Func && func) ->
-   typename std::enable_if<std::is_same<Ret, void>::value,
-      std::pair<std::packaged_task<void(T &)>, std::future<void>>>::type
+template <typename Ret, typename Func, typename T>
+void call_fulfilling_promise(std::promise<Ret> & promise, Func & func, T & data)
 {
-   std::packaged_task<void(T &)> task(std::forward<Func>(func));
-   std::future<void> task_future(task.get_future());
-
-   return std::make_pair(std::move(task), std::move(task_future));
-}
+   try {
+      if constexpr (std::is_same_v<Ret, void>) {
+         func(data);
+         promise.set_value();
 
-template <typename Ret, typename T, typename Func>
-auto package_task_void(Func && func) ->
-   typename std::enable_if<!std::is_same<Ret, void>::value,
-      std::pair<std::packaged_task<void(T &)>, std::future<T>>>::type
-{
-   std::packaged_task<Ret(T &)> task(std::forward<Func>(func));
-   std::future<Ret> task_future(task.get_future());
+      } else {
+         promise.set_value(func(data));
+      }
 
-   return std::make_pair(std::packaged_task<void(T &)>(std::move(task)), std::move(task_future));
+   } catch (...) {
+      promise.set_exception(std::current_exception());
+   }
 }
 
 template <typename T, typename M>
@@ -200,51 +1045,186 @@ auto deferred_guarded<T, M>::modify_async(Func && func) ->
    using future_t = std::future<decltype(func(m_obj))>;
    future_t retval;
 
+   release_notifier notifier(*this);
+   resume_list ready;
    std::unique_lock<M> lock(m_mutex, std::try_to_lock);
 
-   if (lock.owns_lock()) {
-      if (m_pendingWrites.load()) {
-         std::vector<std::packaged_task<void(T &)>> localPending;
+   if (! lock.owns_lock()) {
+      if (acquire_pending_slot()) {
+         std::promise<return_t> promise;
+         retval = promise.get_future();
 
-         m_pendingWrites.store(false);
-         swap(localPending, *(m_pendingList.lock()));
-         for (auto & f : localPending) {
-            f(m_obj);
-         }
+         push_pending_write(task_type(
+               [promise = std::move(promise), func = std::forward<Func>(func)](T & obj) mutable {
+                  call_fulfilling_promise(promise, func, obj);
+               }));
+
+         return retval;
       }
 
-      retval = call_returning_future<return_t>(func, m_obj);
+      if (m_overflowPolicy == overflow_policy::reject) {
+         std::promise<return_t> promise;
+         promise.set_exception(std::make_exception_ptr(pending_limit_exceeded()));
 
-   } else {
-      std::pair<std::packaged_task<void(T &)>, std::future<return_t>> task_future =
-            package_task_void<return_t, T>(std::forward<Func>(func));
+         return promise.get_future();
+      }
 
-      retval = std::move(task_future.second);
+      lock.lock();
+   }
 
-      m_pendingList.lock()->push_back(std::move(task_future.first));
-      m_pendingWrites.store(true);
+   if (m_pendingWrites.load()) {
+      drain_pending_writes(ready);
    }
 
+   retval = call_returning_future<return_t>(func, m_obj);
+
    return retval;
 }
 
+template <typename T, typename M>
+template <typename Func>
+class deferred_guarded<T, M>::modify_awaiter
+{
+   public:
+      using result_type = decltype(std::declval<Func &>()(declref<T>()));
+
+      modify_awaiter(deferred_guarded & guarded, Func func)
+         : m_guarded(guarded), m_func(std::move(func))
+      {
+      }
+
+      modify_awaiter(const modify_awaiter &) = delete;
+      modify_awaiter &operator=(const modify_awaiter &) = delete;
+
+      bool await_ready();
+      bool await_suspend(std::coroutine_handle<> handle);
+      result_type await_resume();
+
+   private:
+      using stored_type = std::conditional_t<std::is_void_v<result_type>, bool,
+            std::conditional_t<std::is_reference_v<result_type>,
+            std::reference_wrapper<std::remove_reference_t<result_type>>, result_type>>;
+
+      // never throws, an exception is rethrown by await_resume()
+      void apply(T & obj);
+
+      deferred_guarded & m_guarded;
+      Func m_func;
+
+      pending_node m_node;
+
+      std::optional<stored_type> m_value;
+      std::exception_ptr m_exception;
+};
+
+template <typename T, typename M>
+template <typename Func>
+void deferred_guarded<T, M>::modify_awaiter<Func>::apply(T & obj)
+{
+   try {
+      if constexpr (std::is_void_v<result_type>) {
+         m_func(obj);
+      } else {
+         m_value.emplace(m_func(obj));
+      }
+
+   } catch (...) {
+      m_exception = std::current_exception();
+   }
+}
+
+template <typename T, typename M>
+template <typename Func>
+bool deferred_guarded<T, M>::modify_awaiter<Func>::await_ready()
+{
+   release_notifier notifier(m_guarded);
+   resume_list ready;
+   std::unique_lock<M> lock(m_guarded.m_mutex, std::try_to_lock);
+
+   if (! lock.owns_lock()) {
+      return false;
+   }
+
+   if (m_guarded.m_pendingWrites.load()) {
+      m_guarded.drain_pending_writes(ready);
+   }
+
+   apply(m_guarded.m_obj);
+
+   return true;
+}
+
+template <typename T, typename M>
+template <typename Func>
+bool deferred_guarded<T, M>::modify_awaiter<Func>::await_suspend(std::coroutine_handle<> handle)
+{
+   if (m_guarded.acquire_pending_slot()) {
+      m_node.m_task = task_type([this](T & obj) { apply(obj); });
+      m_node.m_continuation = handle;
+
+      // the coroutine may be resumed on another thread before this returns
+      m_guarded.push_pending_node(&m_node);
+
+      return true;
+   }
+
+   if (m_guarded.m_overflowPolicy == overflow_policy::reject) {
+      m_exception = std::make_exception_ptr(pending_limit_exceeded());
+      return false;
+   }
+
+   release_notifier notifier(m_guarded);
+   resume_list ready;
+   std::unique_lock<M> lock(m_guarded.m_mutex);
+
+   if (m_guarded.m_pendingWrites.load()) {
+      m_guarded.drain_pending_writes(ready);
+   }
+
+   apply(m_guarded.m_obj);
+
+   return false;
+}
+
+template <typename T, typename M>
+template <typename Func>
+auto deferred_guarded<T, M>::modify_awaiter<Func>::await_resume() -> result_type
+{
+   if (m_exception) {
+      std::rethrow_exception(m_exception);
+   }
+
+   if constexpr (std::is_reference_v<result_type>) {
+      return m_value->get();
+
+   } else if constexpr (! std::is_void_v<result_type>) {
+      return std::move(*m_value);
+   }
+}
+
+template <typename T, typename M>
+template <typename Func>
+auto deferred_guarded<T, M>::co_modify(Func && func) -> modify_awaiter<std::decay_t<Func>>
+{
+   return modify_awaiter<std::decay_t<Func>>(*this, std::forward<Func>(func));
+}
+
 template <typename T, typename M>
 void deferred_guarded<T, M>::do_pending_writes() const
 {
+   if (m_drainMode != drain_mode::inline_drain) {
+      // queued writes are applied by the executor or drain thread
+      return;
+   }
+
    if (m_pendingWrites.load()) {
 
+      resume_list ready;
       std::unique_lock<M> lock(m_mutex, std::try_to_lock);
 
       if (lock.owns_lock()) {
          if (m_pendingWrites.load()) {
-            std::vector<std::packaged_task<void(T &)>> localPending;
-
-            m_pendingWrites.store(false);
-            swap(localPending, *(m_pendingList.lock()));
-
-            for (auto & f : localPending) {
-               f(m_obj);
-            }
+            drain_pending_writes(ready);
          }
       }
    }
@@ -253,10 +1233,14 @@ void deferred_guarded<T, M>::do_pending_writes() const
 template <typename T, typename M>
 auto deferred_guarded<T, M>::lock_shared() const -> shared_handle
 {
+   if (m_fairPending != 0 || m_fairStaleness != std::chrono::nanoseconds::zero()) {
+      enforce_fairness();
+   }
+
    do_pending_writes();
    m_mutex.lock_shared();
 
-   return shared_handle(&m_obj, shared_deleter(m_mutex));
+   return shared_handle(&m_obj, shared_deleter(*this));
 }
 
 template <typename T, typename M>
@@ -264,9 +1248,9 @@ auto deferred_guarded<T, M>::try_lock_shared() const -> shared_handle
 {
    do_pending_writes();
    if (m_mutex.try_lock_shared()) {
-      return shared_handle(&m_obj, shared_deleter(m_mutex));
+      return shared_handle(&m_obj, shared_deleter(*this));
    } else {
-      return shared_handle(nullptr, shared_deleter(m_mutex));
+      return shared_handle(nullptr, shared_deleter(*this));
    }
 }
 
@@ -276,9 +1260,9 @@ auto deferred_guarded<T, M>::try_lock_shared_for(const Duration & d) const -> sh
 {
    do_pending_writes();
    if (m_mutex.try_lock_shared_for(d)) {
-      return shared_handle(&m_obj, shared_deleter(m_mutex));
+      return shared_handle(&m_obj, shared_deleter(*this));
    } else {
-      return shared_handle(nullptr, shared_deleter(m_mutex));
+      return shared_handle(nullptr, shared_deleter(*this));
    }
 }
 
@@ -288,9 +1272,9 @@ auto deferred_guarded<T, M>::try_lock_shared_until(const TimePoint & tp) const -
 {
    do_pending_writes();
    if (m_mutex.try_lock_shared_until(tp)) {
-      return shared_handle(&m_obj, shared_deleter(m_mutex));
+      return shared_handle(&m_obj, shared_deleter(*this));
    } else {
-      return shared_handle(nullptr, shared_deleter(m_mutex));
+      return shared_handle(nullptr, shared_deleter(*this));
    }
 }
 
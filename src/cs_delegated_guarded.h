@@ -0,0 +1,173 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_DELEGATED_GUARDED_H
+#define CSLIBGUARDED_DELEGATED_GUARDED_H
+
+#include "cs_operation_slots.h"
+#include "cs_spin_wait.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_delegated_guarded.h <CsLibGuarded/cs_delegated_guarded.h>
+
+   This templated class wraps an object which is owned by a dedicated
+   server thread. No other thread ever accesses the protected object and
+   no lock is acquired.
+
+   A thread calling modify() publishes the functor in a slot on its own
+   cache line and waits while the server thread runs it. The server runs
+   every published functor in one pass, so the protected object stays in
+   the cache of the processor which runs the server.
+
+   The value returned by the functor is returned by modify(), as is any
+   exception it throws. The functor must not call modify() on the same
+   object since the server thread would wait for itself.
+
+   The server thread is started by the constructor and joined by the
+   destructor. While idle it spins briefly and then sleeps until an
+   operation is published.
+*/
+template <typename T>
+class delegated_guarded
+{
+   public:
+      /**
+        Construct a guarded object and start the server thread. This
+        constructor will accept any number of parameters, all of which are
+        forwarded to the constructor of T.
+       */
+      template <typename... Us>
+      delegated_guarded(Us &&... data);
+
+      ~delegated_guarded();
+
+      delegated_guarded(const delegated_guarded &) = delete;
+      delegated_guarded &operator=(const delegated_guarded &) = delete;
+
+      /**
+        Calls func on the server thread with a reference to the protected
+        object. Returns the result by value once func has run.
+      */
+      template <typename Func>
+      auto modify(Func &&func);
+
+   private:
+      void run_server();
+
+      T m_obj;
+
+      detail::operation_slots<T, true> m_slots;
+
+      // incremented for every published operation, the server sleeps on it
+      alignas(64) std::atomic<std::uint32_t> m_signal = 0;
+      std::atomic<bool> m_stop = false;
+
+      std::thread m_server;
+};
+
+template <typename T>
+template <typename... Us>
+delegated_guarded<T>::delegated_guarded(Us &&... data)
+   : m_obj(std::forward<Us>(data)...)
+{
+   m_server = std::thread(&delegated_guarded::run_server, this);
+}
+
+template <typename T>
+delegated_guarded<T>::~delegated_guarded()
+{
+   m_stop.store(true);
+
+   m_signal.fetch_add(1, std::memory_order_release);
+   m_signal.notify_one();
+
+   m_server.join();
+}
+
+template <typename T>
+template <typename Func>
+auto delegated_guarded<T>::modify(Func &&func)
+{
+   using operation_slots = detail::operation_slots<T, true>;
+
+   detail::published_operation<T, std::remove_reference_t<Func>> op(func);
+
+   auto *slot = m_slots.claim();
+
+   for (detail::spin_wait backoff; slot == nullptr; slot = m_slots.claim()) {
+      // every slot is in use, wait for another thread to finish
+      backoff.wait();
+   }
+
+   m_slots.publish(*slot, op);
+
+   m_signal.fetch_add(1, std::memory_order_release);
+   m_signal.notify_one();
+
+   detail::spin_wait backoff;
+
+   while (backoff.is_spinning()) {
+      if (operation_slots::is_done(*slot)) {
+         break;
+      }
+
+      backoff.wait();
+   }
+
+   operation_slots::wait_done(*slot);
+   operation_slots::release(*slot);
+
+   return op.get();
+}
+
+template <typename T>
+void delegated_guarded<T>::run_server()
+{
+   detail::spin_wait backoff;
+
+   while (true) {
+      std::uint32_t signal = m_signal.load(std::memory_order_acquire);
+
+      if (m_slots.run_pending(m_obj) != 0) {
+         backoff.reset();
+         continue;
+      }
+
+      if (m_stop.load()) {
+         break;
+      }
+
+      if (backoff.is_spinning()) {
+         backoff.wait();
+      } else {
+         m_signal.wait(signal, std::memory_order_acquire);
+      }
+   }
+}
+
+}  // namespace libguarded
+
+#endif
@@ -0,0 +1,223 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_DISTRIBUTED_SHARED_MUTEX_H
+#define CSLIBGUARDED_DISTRIBUTED_SHARED_MUTEX_H
+
+#include "cs_reader_indicator.h"
+#include "cs_spin_wait.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_distributed_shared_mutex.h <CsLibGuarded/cs_distributed_shared_mutex.h>
+
+   This templated class is a reader-writer mutex which meets the
+   requirements of SharedTimedMutex and can be used as the mutex type for
+   shared_guarded, ordered_guarded, and deferred_guarded.
+
+   Readers register in one of a fixed number of counters, each on its own
+   cache line, so concurrent readers on different threads do not contend on
+   a shared word. A writer must scan every counter, which makes exclusive
+   locking more expensive than with std::shared_mutex. This trade off
+   favors data which is read much more often than it is written.
+
+   Writers are serialized on WriterMutex. Once a writer has announced
+   itself new readers wait, so writers are not starved by readers. The
+   timed lock methods poll until the timeout expires.
+
+   The size of this class is several kilobytes.
+*/
+template <typename WriterMutex = std::mutex>
+class basic_distributed_shared_mutex
+{
+   public:
+      basic_distributed_shared_mutex() = default;
+
+      basic_distributed_shared_mutex(const basic_distributed_shared_mutex &) = delete;
+      basic_distributed_shared_mutex &operator=(const basic_distributed_shared_mutex &) = delete;
+
+      void lock();
+      bool try_lock();
+      void unlock();
+
+      template <class Duration>
+      bool try_lock_for(const Duration &duration);
+
+      template <class TimePoint>
+      bool try_lock_until(const TimePoint &timepoint);
+
+      void lock_shared();
+      bool try_lock_shared();
+      void unlock_shared();
+
+      template <class Duration>
+      bool try_lock_shared_for(const Duration &duration);
+
+      template <class TimePoint>
+      bool try_lock_shared_until(const TimePoint &timepoint);
+
+   private:
+      // releases the writer flag and wakes readers which are waiting on it
+      void clear_writer();
+
+      detail::reader_indicator m_readers;
+
+      alignas(64) std::atomic<bool> m_writer = false;
+      WriterMutex m_writerMutex;
+};
+
+using distributed_shared_mutex = basic_distributed_shared_mutex<>;
+
+template <typename WM>
+void basic_distributed_shared_mutex<WM>::lock()
+{
+   m_writerMutex.lock();
+   m_writer.store(true);
+
+   detail::spin_wait backoff;
+
+   while (! m_readers.empty()) {
+      backoff.wait();
+   }
+}
+
+template <typename WM>
+bool basic_distributed_shared_mutex<WM>::try_lock()
+{
+   if (! m_writerMutex.try_lock()) {
+      return false;
+   }
+
+   m_writer.store(true);
+
+   if (! m_readers.empty()) {
+      clear_writer();
+      m_writerMutex.unlock();
+
+      return false;
+   }
+
+   return true;
+}
+
+template <typename WM>
+void basic_distributed_shared_mutex<WM>::unlock()
+{
+   clear_writer();
+   m_writerMutex.unlock();
+}
+
+template <typename WM>
+template <class Duration>
+bool basic_distributed_shared_mutex<WM>::try_lock_for(const Duration &duration)
+{
+   return try_lock_until(std::chrono::steady_clock::now() + duration);
+}
+
+template <typename WM>
+template <class TimePoint>
+bool basic_distributed_shared_mutex<WM>::try_lock_until(const TimePoint &timepoint)
+{
+   detail::spin_wait backoff;
+
+   while (! try_lock()) {
+      if (TimePoint::clock::now() >= timepoint) {
+         return false;
+      }
+
+      backoff.wait();
+   }
+
+   return true;
+}
+
+template <typename WM>
+void basic_distributed_shared_mutex<WM>::lock_shared()
+{
+   while (true) {
+      m_readers.arrive();
+
+      if (! m_writer.load()) {
+         return;
+      }
+
+      // a writer is waiting or active, back off so it can proceed
+      m_readers.depart();
+      m_writer.wait(true);
+   }
+}
+
+template <typename WM>
+bool basic_distributed_shared_mutex<WM>::try_lock_shared()
+{
+   m_readers.arrive();
+
+   if (! m_writer.load()) {
+      return true;
+   }
+
+   m_readers.depart();
+
+   return false;
+}
+
+template <typename WM>
+void basic_distributed_shared_mutex<WM>::unlock_shared()
+{
+   m_readers.depart();
+}
+
+template <typename WM>
+template <class Duration>
+bool basic_distributed_shared_mutex<WM>::try_lock_shared_for(const Duration &duration)
+{
+   return try_lock_shared_until(std::chrono::steady_clock::now() + duration);
+}
+
+template <typename WM>
+template <class TimePoint>
+bool basic_distributed_shared_mutex<WM>::try_lock_shared_until(const TimePoint &timepoint)
+{
+   detail::spin_wait backoff;
+
+   while (! try_lock_shared()) {
+      if (TimePoint::clock::now() >= timepoint) {
+         return false;
+      }
+
+      backoff.wait();
+   }
+
+   return true;
+}
+
+template <typename WM>
+void basic_distributed_shared_mutex<WM>::clear_writer()
+{
+   m_writer.store(false);
+   m_writer.notify_all();
+}
+
+}  // namespace libguarded
+
+#endif
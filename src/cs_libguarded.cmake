@@ -14,15 +14,30 @@ target_include_directories(CsLibGuarded
 )
 
 set(CS_LIBGUARDED_INCLUDES
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_adaptive_mutex.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_cohort_mutex.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_combining_guarded.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_cow_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_cow_rcu_guarded.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_deferred_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_delegated_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_distributed_shared_mutex.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_plain_guarded.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_lock_guards.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_lr_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_mcs_mutex.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_operation_slots.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_ordered_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_persistent_map.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_persistent_vector.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_rcu_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_reader_indicator.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_rcu_list.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_seqlock_guarded.h
    ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_shared_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_sharded_guarded.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_spin_wait.h
+   ${CMAKE_CURRENT_SOURCE_DIR}/src/cs_upgrade_mutex.h
 )
 
 install(
@@ -19,6 +19,7 @@
 #define CSLIBGUARDED_LR_GUARDED_H
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -45,6 +46,11 @@ namespace libguarded
    turn. Therefore the lr_guarded object will consume twice as much
    memory as one T plus a small amount of overhead.
 
+   Every call to modify() publishes a new version of the data. Versions
+   start at zero and increase by one for each completed modification. The
+   version seen by a reader is available from the shared_handle by calling
+   handle.get_deleter().version().
+
  The T class must be copy constructible and copy assignable.
 */
 template <typename T, typename Mutex = std::mutex>
@@ -74,9 +80,18 @@ class lr_guarded
         copy. If the second invocation throws, the modification will be
         completed by copying from the changed copy. In either case if the
         copy constructor throws, the data is left in an indeterminate state.
+
+        Returns the version number assigned to this modification. Once
+        modify() returns, every new shared_handle will observe this
+        version or a later one.
        */
       template <typename Func>
-      void modify(Func && f);
+      std::uint64_t modify(Func && f);
+
+      /**
+        Returns the most recently published version number.
+      */
+      [[nodiscard]] std::uint64_t version() const;
 
       /**
         Acquire a shared_handle to the protected object. Always succeeds without blocking.
@@ -100,30 +115,43 @@ class lr_guarded
       template <class TimePoint>
       [[nodiscard]] shared_handle try_lock_shared_until(const TimePoint & timepoint) const;
 
+      /**
+        Acquire a shared_handle to the protected object if the currently
+        published version is at least the given version. Returns a null
+        handle if that version has not been published yet. Never blocks.
+
+        Passing the value returned by modify() guarantees a thread will
+        read its own writes.
+      */
+      [[nodiscard]] shared_handle lock_shared_at_least(std::uint64_t version) const;
+
    private:
       class shared_deleter
       {
          public:
             using pointer = const T *;
 
-            shared_deleter() : m_readingCount(nullptr) {}
+            shared_deleter() : m_readingCount(nullptr), m_version(0) {}
 
             shared_deleter(const shared_deleter &) = delete;
             shared_deleter& operator=(const shared_deleter&) = delete;
 
 	    shared_deleter(shared_deleter && other)
-	       : m_readingCount(other.m_readingCount)
+	       : m_readingCount(other.m_readingCount), m_version(other.m_version)
 	    {
 	       other.m_readingCount = nullptr;
 	    }
 
 	    shared_deleter& operator=(shared_deleter&& other) & {
 	       m_readingCount = other.m_readingCount;
+	       m_version      = other.m_version;
 	       other.m_readingCount = nullptr;
+
+	       return *this;
 	    }
 
-            shared_deleter(std::atomic<int> & readingCount)
-               : m_readingCount(&readingCount)
+            shared_deleter(std::atomic<int> & readingCount, std::uint64_t version)
+               : m_readingCount(&readingCount), m_version(version)
             {
             }
 
@@ -133,12 +161,28 @@ class lr_guarded
                }
             }
 
+            /**
+              Returns the version of the data this handle refers to.
+            */
+            std::uint64_t version() const {
+               return m_version;
+            }
+
          private:
             std::atomic<int> * m_readingCount;
+            std::uint64_t      m_version;
       };
 
+      shared_handle make_shared_handle(std::atomic<int> & readingCount) const;
+
       T                        m_left;
       T                        m_right;
+
+      // versions are only written by the writer while no reader can observe that copy
+      std::uint64_t            m_leftVersion;
+      std::uint64_t            m_rightVersion;
+
+      std::atomic<std::uint64_t> m_version;
       std::atomic<bool>        m_readingLeft;
       std::atomic<bool>        m_countingLeft;
       mutable std::atomic<int> m_leftReadCount;
@@ -149,14 +193,14 @@ class lr_guarded
 template <typename T, typename M>
 template <typename... Us>
 lr_guarded<T, M>::lr_guarded(Us &&... data)
-   : m_left(std::forward<Us>(data)...), m_right(m_left), m_readingLeft(true), m_countingLeft(true),
-     m_leftReadCount(0), m_rightReadCount(0)
+   : m_left(std::forward<Us>(data)...), m_right(m_left), m_leftVersion(0), m_rightVersion(0),
+     m_version(0), m_readingLeft(true), m_countingLeft(true), m_leftReadCount(0), m_rightReadCount(0)
 {
 }
 
 template <typename T, typename M>
 template <typename Func>
-void lr_guarded<T, M>::modify(Func && func)
+std::uint64_t lr_guarded<T, M>::modify(Func && func)
 {
    // consider looser memory ordering
 
@@ -165,14 +209,21 @@ void lr_guarded<T, M>::modify(Func && func)
    T *firstWriteLocation;
    T *secondWriteLocation;
 
+   std::uint64_t *firstVersion;
+   std::uint64_t *secondVersion;
+
    bool local_readingLeft = m_readingLeft.load();
 
    if (local_readingLeft) {
       firstWriteLocation  = &m_right;
       secondWriteLocation = &m_left;
+      firstVersion        = &m_rightVersion;
+      secondVersion       = &m_leftVersion;
    } else {
       firstWriteLocation  = &m_left;
       secondWriteLocation = &m_right;
+      firstVersion        = &m_leftVersion;
+      secondVersion       = &m_rightVersion;
    }
 
    try {
@@ -182,7 +233,11 @@ void lr_guarded<T, M>::modify(Func && func)
       throw;
    }
 
+   const std::uint64_t newVersion = m_version.load() + 1;
+   *firstVersion = newVersion;
+
    m_readingLeft.store(! local_readingLeft);
+   m_version.store(newVersion);
 
    bool local_countingLeft = m_countingLeft.load();
 
@@ -210,12 +265,32 @@ void lr_guarded<T, M>::modify(Func && func)
       }
    }
 
+   *secondVersion = newVersion;
+
    try {
       func(*secondWriteLocation);
    } catch (...) {
       *secondWriteLocation = *firstWriteLocation;
       throw;
    }
+
+   return newVersion;
+}
+
+template <typename T, typename M>
+std::uint64_t lr_guarded<T, M>::version() const
+{
+   return m_version.load();
+}
+
+template <typename T, typename M>
+auto lr_guarded<T, M>::make_shared_handle(std::atomic<int> & readingCount) const -> shared_handle
+{
+   if (m_readingLeft) {
+      return shared_handle(&m_left, shared_deleter(readingCount, m_leftVersion));
+   } else {
+      return shared_handle(&m_right, shared_deleter(readingCount, m_rightVersion));
+   }
 }
 
 template <typename T, typename M>
@@ -223,21 +298,11 @@ auto lr_guarded<T, M>::lock_shared() const -> shared_handle
 {
    if (m_countingLeft) {
       ++m_leftReadCount;
-
-      if (m_readingLeft) {
-         return shared_handle(&m_left, shared_deleter(m_leftReadCount));
-      } else {
-         return shared_handle(&m_right, shared_deleter(m_leftReadCount));
-      }
+      return make_shared_handle(m_leftReadCount);
 
    } else {
       ++m_rightReadCount;
-
-      if (m_readingLeft) {
-         return shared_handle(&m_left, shared_deleter(m_rightReadCount));
-      } else {
-         return shared_handle(&m_right, shared_deleter(m_rightReadCount));
-      }
+      return make_shared_handle(m_rightReadCount);
    }
 }
 
@@ -261,6 +326,18 @@ auto lr_guarded<T, M>::try_lock_shared_until(const TimePoint &) const -> shared_
    return lock_shared();
 }
 
+template <typename T, typename M>
+auto lr_guarded<T, M>::lock_shared_at_least(std::uint64_t version) const -> shared_handle
+{
+   shared_handle retval = lock_shared();
+
+   if (retval.get_deleter().version() < version) {
+      retval.reset();
+   }
+
+   return retval;
+}
+
 }  // namespace libguarded
 
 #endif
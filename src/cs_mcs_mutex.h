@@ -0,0 +1,234 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_MCS_MUTEX_H
+#define CSLIBGUARDED_MCS_MUTEX_H
+
+#include "cs_spin_wait.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+struct alignas(64) mcs_node {
+   std::atomic<mcs_node *> m_next = nullptr;
+   std::atomic<std::uint32_t> m_waiting = 0;
+
+   // link in the free list of the owning thread or the shared free list
+   mcs_node *m_nextFree = nullptr;
+};
+
+/**
+   Queue nodes for the current thread. A node is allocated the first time
+   a thread holds more mutexes at once than it has before, afterwards
+   nodes are reused.
+
+   Nodes are never freed. When a thread exits its nodes are moved to a
+   shared free list, since the thread which handed it the mutex may still
+   be calling notify_one() on its node.
+*/
+class mcs_node_pool
+{
+   public:
+      mcs_node_pool() = default;
+
+      mcs_node_pool(const mcs_node_pool &) = delete;
+      mcs_node_pool &operator=(const mcs_node_pool &) = delete;
+
+      ~mcs_node_pool() {
+         if (m_free == nullptr) {
+            return;
+         }
+
+         mcs_node *last = m_free;
+
+         while (last->m_nextFree != nullptr) {
+            last = last->m_nextFree;
+         }
+
+         shared_free_list &shared = shared_list();
+         std::lock_guard<std::mutex> lock(shared.m_mutex);
+
+         last->m_nextFree = shared.m_free;
+         shared.m_free    = m_free;
+      }
+
+      static mcs_node *acquire() {
+         mcs_node_pool &pool = local();
+
+         if (pool.m_free == nullptr) {
+            shared_free_list &shared = shared_list();
+            std::lock_guard<std::mutex> lock(shared.m_mutex);
+
+            if (shared.m_free == nullptr) {
+               return new mcs_node;
+            }
+
+            mcs_node *node = std::exchange(shared.m_free, shared.m_free->m_nextFree);
+            node->m_next.store(nullptr, std::memory_order_relaxed);
+
+            return node;
+         }
+
+         mcs_node *node = std::exchange(pool.m_free, pool.m_free->m_nextFree);
+         node->m_next.store(nullptr, std::memory_order_relaxed);
+
+         return node;
+      }
+
+      static void release(mcs_node *node) {
+         mcs_node_pool &pool = local();
+
+         node->m_nextFree = pool.m_free;
+         pool.m_free      = node;
+      }
+
+   private:
+      struct shared_free_list {
+         std::mutex m_mutex;
+         mcs_node *m_free = nullptr;
+      };
+
+      static mcs_node_pool &local() {
+         thread_local mcs_node_pool pool;
+         return pool;
+      }
+
+      static shared_free_list &shared_list() {
+         // never destroyed, threads may exit after static destruction has started
+         static shared_free_list *list = new shared_free_list;
+         return *list;
+      }
+
+      mcs_node *m_free = nullptr;
+};
+
+}  // namespace detail
+
+/**
+   \headerfile cs_mcs_mutex.h <CsLibGuarded/cs_mcs_mutex.h>
+
+   This class is a queue based mutex which meets the requirements of
+   Lockable and can be used as the mutex type for plain_guarded.
+
+   Threads waiting for the mutex form a FIFO queue. Each waiter spins on a
+   flag in its own queue node, on its own cache line, and the owner hands
+   the mutex directly to the next waiter when it unlocks. Contention does
+   not increase cache coherence traffic on the mutex itself and the mutex
+   is granted in the order it was requested. A waiter which spins for too
+   long sleeps using std::atomic::wait.
+
+   Queue nodes are taken from a pool local to each thread and reused, so
+   locking does not allocate once a thread has warmed up. Timed locking
+   is not supported since a waiter can not leave the queue.
+*/
+class mcs_mutex
+{
+   public:
+      mcs_mutex() = default;
+
+      mcs_mutex(const mcs_mutex &) = delete;
+      mcs_mutex &operator=(const mcs_mutex &) = delete;
+
+      void lock();
+      bool try_lock();
+      void unlock();
+
+   private:
+      std::atomic<detail::mcs_node *> m_tail = nullptr;
+
+      // only accessed by the thread which owns the mutex
+      detail::mcs_node *m_owner = nullptr;
+};
+
+inline void mcs_mutex::lock()
+{
+   detail::mcs_node *node = detail::mcs_node_pool::acquire();
+   node->m_waiting.store(1, std::memory_order_relaxed);
+
+   detail::mcs_node *prev = m_tail.exchange(node, std::memory_order_acq_rel);
+
+   if (prev != nullptr) {
+      prev->m_next.store(node, std::memory_order_release);
+
+      detail::spin_wait backoff;
+
+      while (node->m_waiting.load(std::memory_order_acquire) != 0) {
+         if (backoff.is_spinning()) {
+            backoff.wait();
+         } else {
+            node->m_waiting.wait(1, std::memory_order_acquire);
+         }
+      }
+   }
+
+   m_owner = node;
+}
+
+inline bool mcs_mutex::try_lock()
+{
+   detail::mcs_node *node     = detail::mcs_node_pool::acquire();
+   detail::mcs_node *expected = nullptr;
+
+   if (! m_tail.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+      detail::mcs_node_pool::release(node);
+      return false;
+   }
+
+   m_owner = node;
+
+   return true;
+}
+
+inline void mcs_mutex::unlock()
+{
+   detail::mcs_node *node = m_owner;
+   detail::mcs_node *next = node->m_next.load(std::memory_order_acquire);
+
+   if (next == nullptr) {
+      detail::mcs_node *expected = node;
+
+      if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+         detail::mcs_node_pool::release(node);
+         return;
+      }
+
+      // a new waiter has swapped the tail but not linked itself yet
+      detail::spin_wait backoff;
+
+      while ((next = node->m_next.load(std::memory_order_acquire)) == nullptr) {
+         backoff.wait();
+      }
+   }
+
+   detail::mcs_node_pool::release(node);
+
+   // the successor may already have released its node, nodes are never freed so the notify is safe
+   next->m_waiting.store(0, std::memory_order_release);
+   next->m_waiting.notify_one();
+}
+
+}  // namespace libguarded
+
+#endif
@@ -0,0 +1,214 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_OPERATION_SLOTS_H
+#define CSLIBGUARDED_OPERATION_SLOTS_H
+
+#include "cs_reader_indicator.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+/**
+   An operation published by a thread which waits for another thread to
+   run it. The object lives on the stack of the publishing thread, which
+   must not return until the operation is done.
+*/
+template <typename T, typename Func>
+class published_operation
+{
+   public:
+      using result_type = std::decay_t<std::invoke_result_t<Func &, T &>>;
+
+      explicit published_operation(Func &func)
+         : m_func(func)
+      {
+      }
+
+      published_operation(const published_operation &) = delete;
+      published_operation &operator=(const published_operation &) = delete;
+
+      // exceptions thrown by the functor are passed to the publishing thread
+      static void invoke(void *self, T &obj) noexcept {
+         published_operation *op = static_cast<published_operation *>(self);
+
+         try {
+            if constexpr (std::is_void_v<result_type>) {
+               std::invoke(op->m_func, obj);
+            } else {
+               op->m_result.emplace(std::invoke(op->m_func, obj));
+            }
+
+         } catch (...) {
+            op->m_exception = std::current_exception();
+         }
+      }
+
+      result_type get() {
+         if (m_exception) {
+            std::rethrow_exception(m_exception);
+         }
+
+         if constexpr (! std::is_void_v<result_type>) {
+            return std::move(*m_result);
+         }
+      }
+
+   private:
+      struct no_result {
+      };
+
+      Func &m_func;
+
+      std::conditional_t<std::is_void_v<result_type>, no_result, std::optional<result_type>> m_result;
+      std::exception_ptr m_exception;
+};
+
+/**
+   Fixed array of publication slots, each on its own cache line. A thread
+   claims a slot, publishes an operation in it, and waits until another
+   thread which owns T has run the operation.
+
+   When Waitable is true a thread may sleep in wait_done() until its
+   operation has run, and run_pending() wakes it.
+*/
+template <typename T, bool Waitable = false>
+class operation_slots
+{
+   public:
+      static constexpr std::size_t slot_count = reader_indicator::slot_count;
+
+      struct alignas(64) slot_type {
+         std::atomic<std::uint32_t> m_state = 0;
+
+         void (*m_invoke)(void *, T &) = nullptr;
+         void *m_context = nullptr;
+      };
+
+      operation_slots() = default;
+
+      operation_slots(const operation_slots &) = delete;
+      operation_slots &operator=(const operation_slots &) = delete;
+
+      /**
+        Returns a slot for the calling thread, or nullptr if every slot is
+        in use. The slot assigned to the calling thread is tried first.
+      */
+      slot_type *claim() {
+         std::size_t start = reader_indicator::current_slot();
+
+         for (std::size_t i = 0; i < slot_count; ++i) {
+            slot_type &slot = m_slots[(start + i) % slot_count];
+
+            std::uint32_t expected = slot_free;
+
+            if (slot.m_state.load(std::memory_order_relaxed) == slot_free &&
+                  slot.m_state.compare_exchange_strong(expected, slot_claimed, std::memory_order_acquire)) {
+               return &slot;
+            }
+         }
+
+         return nullptr;
+      }
+
+      template <typename Func>
+      void publish(slot_type &slot, published_operation<T, Func> &op) {
+         slot.m_invoke  = &published_operation<T, Func>::invoke;
+         slot.m_context = &op;
+
+         m_pendingCount.fetch_add(1, std::memory_order_relaxed);
+         slot.m_state.store(slot_pending, std::memory_order_release);
+      }
+
+      // hint only, a thread whose operation is missed runs it once it acquires the mutex
+      bool has_pending() const {
+         return m_pendingCount.load(std::memory_order_relaxed) != 0;
+      }
+
+      static bool is_done(const slot_type &slot) {
+         return slot.m_state.load(std::memory_order_acquire) == slot_done;
+      }
+
+      static void wait_done(const slot_type &slot) {
+         static_assert(Waitable, "wait_done() requires waitable operation slots");
+
+         while (! is_done(slot)) {
+            slot.m_state.wait(slot_pending, std::memory_order_acquire);
+         }
+      }
+
+      static void release(slot_type &slot) {
+         slot.m_state.store(slot_free, std::memory_order_release);
+      }
+
+      /**
+        Runs every published operation which has not run yet. The caller
+        must have exclusive access to obj. Returns the number of operations
+        which were run.
+      */
+      std::size_t run_pending(T &obj) {
+         std::size_t count = 0;
+
+         for (slot_type &slot : m_slots) {
+            if (slot.m_state.load(std::memory_order_acquire) != slot_pending) {
+               continue;
+            }
+
+            slot.m_invoke(slot.m_context, obj);
+            ++count;
+
+            m_pendingCount.fetch_sub(1, std::memory_order_relaxed);
+
+            slot.m_state.store(slot_done, std::memory_order_release);
+
+            if constexpr (Waitable) {
+               slot.m_state.notify_one();
+            }
+         }
+
+         return count;
+      }
+
+   private:
+      static constexpr std::uint32_t slot_free    = 0;
+      static constexpr std::uint32_t slot_claimed = 1;
+      static constexpr std::uint32_t slot_pending = 2;
+      static constexpr std::uint32_t slot_done    = 3;
+
+      std::array<slot_type, slot_count> m_slots;
+
+      alignas(64) std::atomic<std::size_t> m_pendingCount = 0;
+};
+
+}  // namespace detail
+
+}  // namespace libguarded
+
+#endif
@@ -18,10 +18,16 @@
 #ifndef CSLIBGUARDED_ORDERED_GUARDED_H
 #define CSLIBGUARDED_ORDERED_GUARDED_H
 
+#include "cs_seqlock_guarded.h"
+#include "cs_spin_wait.h"
+
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <type_traits>
 #include <shared_mutex>
+#include <utility>
 
 namespace libguarded
 {
@@ -39,6 +45,12 @@ namespace libguarded
 
    The handle returned by the various lock methods is moveable but not
    copyable.
+
+   For a trivially copyable T, modify() also publishes a copy of the
+   object stored as atomic words. read_optimistic() reads this copy
+   without acquiring a lock and validates it against a sequence number.
+   After the given number of failed attempts it falls back to a shared
+   lock. Each call to modify() pays for copying T into the published copy.
 */
 template <typename T, typename M = std::shared_timed_mutex>
 class ordered_guarded
@@ -62,6 +74,10 @@ class ordered_guarded
       template <typename Func>
       [[nodiscard]] decltype(auto) read(Func &&func) const;
 
+      // calls func with a const reference to a copy of the object, requires a trivially copyable T
+      template <typename Func>
+      [[nodiscard]] auto read_optimistic(Func &&func, std::size_t retries = 4) const;
+
       [[nodiscard]] shared_handle lock_shared() const;
       [[nodiscard]] shared_handle try_lock_shared() const;
 
@@ -94,14 +110,25 @@ class ordered_guarded
             M *m_deleter_mutex;
       };
 
+      struct no_snapshot {
+         explicit no_snapshot(const T &) {
+         }
+      };
+
+      using snapshot_type = std::conditional_t<std::is_trivially_copyable_v<T>,
+            detail::seqlock_storage<T>, no_snapshot>;
+
       T m_obj;
       mutable M m_mutex;
+
+      // written only by modify() while m_mutex is held exclusively
+      snapshot_type m_snapshot;
 };
 
 template <typename T, typename M>
 template <typename... Us>
 ordered_guarded<T, M>::ordered_guarded(Us &&... data)
-   : m_obj(std::forward<Us>(data)...)
+   : m_obj(std::forward<Us>(data)...), m_snapshot(m_obj)
 {
 }
 
@@ -111,7 +138,21 @@ decltype(auto) ordered_guarded<T, M>::modify(Func &&func)
 {
    std::lock_guard<M> lock(m_mutex);
 
-   return func(m_obj);
+   if constexpr (std::is_trivially_copyable_v<T>) {
+      // publishes the object for read_optimistic(), also when func throws
+      struct publish_on_exit {
+         ~publish_on_exit() {
+            m_guarded.m_snapshot.store_locked(m_guarded.m_obj);
+         }
+
+         ordered_guarded &m_guarded;
+      } publish{*this};
+
+      return func(m_obj);
+
+   } else {
+      return func(m_obj);
+   }
 }
 
 template <typename T, typename M>
@@ -123,6 +164,26 @@ decltype(auto) ordered_guarded<T, M>::read(Func &&func) const
    return func(m_obj);
 }
 
+template <typename T, typename M>
+template <typename Func>
+auto ordered_guarded<T, M>::read_optimistic(Func &&func, std::size_t retries) const
+{
+   static_assert(std::is_trivially_copyable_v<T>, "read_optimistic() requires a trivially copyable type");
+
+   detail::spin_wait backoff;
+
+   for (std::size_t i = 0; i < retries; ++i) {
+      if (std::optional<T> copy = m_snapshot.try_load()) {
+         return func(std::as_const(*copy));
+      }
+
+      backoff.wait();
+   }
+
+   std::shared_lock<M> lock(m_mutex);
+   return func(std::as_const(m_obj));
+}
+
 template <typename T, typename M>
 auto ordered_guarded<T, M>::lock_shared() const -> shared_handle
 {
@@ -0,0 +1,685 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#ifndef CSLIBGUARDED_PERSISTENT_MAP_H
+#define CSLIBGUARDED_PERSISTENT_MAP_H
+
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_persistent_map.h <CsLibGuarded/cs_persistent_map.h>
+
+   This templated class is an unordered map implemented as a hash array
+   mapped trie. Nodes are immutable and shared between copies, so copying
+   a persistent_map is O(1) and modifying a copy only allocates the
+   O(log n) nodes on the path to the changed element.
+
+   This class is designed to be used as the T of cow_guarded. The copy
+   made by cow_guarded::lock() shares all of its nodes with the existing
+   snapshots and each write through the handle only copies the path it
+   touches.
+
+   Elements are read only and stored as std::pair<Key, Value>. Use
+   insert_or_assign() to change the value stored for a key. All iterators and references are invalidated by any
+   modification of the map they were obtained from, but never by
+   modifications made to another copy.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class persistent_map
+{
+   private:
+      struct node;
+      using node_ptr = std::shared_ptr<const node>;
+
+   public:
+      using key_type    = Key;
+      using mapped_type = Value;
+      using value_type  = std::pair<Key, Value>;
+      using size_type   = std::size_t;
+      using hasher      = Hash;
+      using key_equal   = KeyEqual;
+
+      class const_iterator;
+      using iterator = const_iterator;
+
+      persistent_map() = default;
+
+      persistent_map(std::initializer_list<value_type> list);
+
+      [[nodiscard]] size_type size() const {
+         return m_size;
+      }
+
+      [[nodiscard]] bool empty() const {
+         return m_size == 0;
+      }
+
+      [[nodiscard]] const_iterator begin() const;
+      [[nodiscard]] const_iterator end() const;
+
+      [[nodiscard]] const_iterator cbegin() const {
+         return begin();
+      }
+
+      [[nodiscard]] const_iterator cend() const {
+         return end();
+      }
+
+      [[nodiscard]] const_iterator find(const Key &key) const;
+
+      [[nodiscard]] bool contains(const Key &key) const {
+         return find(key) != end();
+      }
+
+      [[nodiscard]] size_type count(const Key &key) const {
+         return contains(key) ? 1 : 0;
+      }
+
+      /**
+        Returns the value stored for the given key. Throws std::out_of_range
+        if the key is not present.
+      */
+      [[nodiscard]] const Value &at(const Key &key) const;
+
+      /**
+        Insert the key and value if the key is not present. Returns true if
+        the element was inserted.
+      */
+      template <typename V>
+      bool insert(const Key &key, V &&value);
+
+      /**
+        Insert the key and value, replacing the value if the key is already
+        present. Returns true if the element was inserted and false if an
+        existing value was replaced.
+      */
+      template <typename V>
+      bool insert_or_assign(const Key &key, V &&value);
+
+      /**
+        Remove the element with the given key. Returns the number of elements removed.
+      */
+      size_type erase(const Key &key);
+
+      void clear() {
+         m_root.reset();
+         m_size = 0;
+      }
+
+   private:
+      static constexpr unsigned bits_per_level = 5;
+      static constexpr unsigned hash_bits      = sizeof(std::size_t) * CHAR_BIT;
+
+      struct node {
+         // entries and children are indexed by the popcount of their bitmap below their bit,
+         // below the last level a node is a collision node and only uses m_values
+         std::uint32_t m_dataMap = 0;
+         std::uint32_t m_nodeMap = 0;
+
+         std::vector<value_type> m_values;
+         std::vector<node_ptr>   m_children;
+      };
+
+      static std::uint32_t fragment(std::size_t hash, unsigned shift) {
+         return static_cast<std::uint32_t>(hash >> shift) & ((1u << bits_per_level) - 1);
+      }
+
+      static unsigned index(std::uint32_t bitmap, std::uint32_t bit) {
+         return std::popcount(bitmap & (bit - 1));
+      }
+
+      static bool is_collision(unsigned shift) {
+         return shift >= hash_bits;
+      }
+
+      template <typename V>
+      node_ptr do_insert(const node *n, std::size_t hash, const Key &key, V &&value, unsigned shift,
+            bool assign, bool &inserted) const;
+
+      template <typename V>
+      node_ptr merge(const value_type &existing, std::size_t existingHash, const Key &key, V &&value,
+            std::size_t hash, unsigned shift) const;
+
+      node_ptr do_erase(const node *n, std::size_t hash, const Key &key, unsigned shift, bool &erased) const;
+
+      node_ptr m_root;
+      size_type m_size = 0;
+
+      [[no_unique_address]] Hash m_hash;
+      [[no_unique_address]] KeyEqual m_equal;
+
+   public:
+      /**
+        Forward iterator over the elements of a persistent_map. The order of
+        iteration is unspecified.
+      */
+      class const_iterator
+      {
+         public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = persistent_map::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const value_type *;
+            using reference         = const value_type &;
+
+            const_iterator() = default;
+
+            reference operator*() const {
+               const auto &[n, pos] = m_stack.back();
+               return n->m_values[pos];
+            }
+
+            pointer operator->() const {
+               return &(**this);
+            }
+
+            const_iterator &operator++() {
+               ++m_stack.back().second;
+               settle();
+
+               return *this;
+            }
+
+            const_iterator operator++(int) {
+               const_iterator retval = *this;
+               ++(*this);
+
+               return retval;
+            }
+
+            bool operator==(const const_iterator &other) const {
+               return m_stack == other.m_stack;
+            }
+
+         private:
+            // each frame holds a node and the position of the next entry to visit,
+            // positions past the values refer to the children
+            using frame = std::pair<const node *, std::size_t>;
+
+            // advance until the top frame refers to a value
+            void settle() {
+               while (! m_stack.empty()) {
+                  const node *n   = m_stack.back().first;
+                  std::size_t pos = m_stack.back().second;
+
+                  if (pos < n->m_values.size()) {
+                     return;
+                  }
+
+                  std::size_t child = pos - n->m_values.size();
+
+                  if (child < n->m_children.size()) {
+                     ++m_stack.back().second;
+                     m_stack.emplace_back(n->m_children[child].get(), 0);
+
+                  } else {
+                     m_stack.pop_back();
+                  }
+               }
+            }
+
+            std::vector<frame> m_stack;
+
+            friend class persistent_map;
+      };
+};
+
+template <typename K, typename V, typename H, typename E>
+persistent_map<K, V, H, E>::persistent_map(std::initializer_list<value_type> list)
+{
+   for (const auto &item : list) {
+      insert_or_assign(item.first, item.second);
+   }
+}
+
+template <typename K, typename V, typename H, typename E>
+auto persistent_map<K, V, H, E>::begin() const -> const_iterator
+{
+   const_iterator retval;
+
+   if (m_root != nullptr) {
+      retval.m_stack.emplace_back(m_root.get(), 0);
+      retval.settle();
+   }
+
+   return retval;
+}
+
+template <typename K, typename V, typename H, typename E>
+auto persistent_map<K, V, H, E>::end() const -> const_iterator
+{
+   return const_iterator();
+}
+
+template <typename K, typename V, typename H, typename E>
+auto persistent_map<K, V, H, E>::find(const K &key) const -> const_iterator
+{
+   const_iterator retval;
+
+   const std::size_t hash = m_hash(key);
+   const node *n          = m_root.get();
+   unsigned shift         = 0;
+
+   while (n != nullptr) {
+      if (is_collision(shift)) {
+         for (std::size_t i = 0; i < n->m_values.size(); ++i) {
+            if (m_equal(n->m_values[i].first, key)) {
+               retval.m_stack.emplace_back(n, i);
+               return retval;
+            }
+         }
+
+         break;
+      }
+
+      const std::uint32_t bit = 1u << fragment(hash, shift);
+
+      if (n->m_dataMap & bit) {
+         unsigned i = index(n->m_dataMap, bit);
+
+         if (m_equal(n->m_values[i].first, key)) {
+            retval.m_stack.emplace_back(n, i);
+            return retval;
+         }
+
+         break;
+
+      } else if (n->m_nodeMap & bit) {
+         unsigned i = index(n->m_nodeMap, bit);
+
+         // resume iteration with the next child after this one is finished
+         retval.m_stack.emplace_back(n, n->m_values.size() + i + 1);
+
+         n = n->m_children[i].get();
+         shift += bits_per_level;
+
+      } else {
+         break;
+      }
+   }
+
+   return const_iterator();
+}
+
+template <typename K, typename V, typename H, typename E>
+const V &persistent_map<K, V, H, E>::at(const K &key) const
+{
+   auto iter = find(key);
+
+   if (iter == end()) {
+      throw std::out_of_range("persistent_map::at: key not found");
+   }
+
+   return iter->second;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename U>
+bool persistent_map<K, V, H, E>::insert(const K &key, U &&value)
+{
+   bool inserted = false;
+   node_ptr newRoot = do_insert(m_root.get(), m_hash(key), key, std::forward<U>(value), 0, false, inserted);
+
+   if (inserted) {
+      m_root = std::move(newRoot);
+      ++m_size;
+   }
+
+   return inserted;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename U>
+bool persistent_map<K, V, H, E>::insert_or_assign(const K &key, U &&value)
+{
+   bool inserted = false;
+   m_root = do_insert(m_root.get(), m_hash(key), key, std::forward<U>(value), 0, true, inserted);
+
+   if (inserted) {
+      ++m_size;
+   }
+
+   return inserted;
+}
+
+template <typename K, typename V, typename H, typename E>
+auto persistent_map<K, V, H, E>::erase(const K &key) -> size_type
+{
+   if (m_root == nullptr) {
+      return 0;
+   }
+
+   bool erased = false;
+   node_ptr newRoot = do_erase(m_root.get(), m_hash(key), key, 0, erased);
+
+   if (! erased) {
+      return 0;
+   }
+
+   m_root = std::move(newRoot);
+   --m_size;
+
+   return 1;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename U>
+auto persistent_map<K, V, H, E>::merge(const value_type &existing, std::size_t existingHash, const K &key,
+      U &&value, std::size_t hash, unsigned shift) const -> node_ptr
+{
+   auto retval = std::make_shared<node>();
+
+   if (is_collision(shift)) {
+      retval->m_values.reserve(2);
+      retval->m_values.push_back(existing);
+      retval->m_values.emplace_back(key, std::forward<U>(value));
+
+      return retval;
+   }
+
+   const std::uint32_t existingFrag = fragment(existingHash, shift);
+   const std::uint32_t frag         = fragment(hash, shift);
+
+   if (existingFrag == frag) {
+      retval->m_nodeMap = 1u << frag;
+      retval->m_children.push_back(merge(existing, existingHash, key, std::forward<U>(value), hash,
+            shift + bits_per_level));
+
+   } else {
+      retval->m_dataMap = (1u << existingFrag) | (1u << frag);
+      retval->m_values.reserve(2);
+
+      if (existingFrag < frag) {
+         retval->m_values.push_back(existing);
+         retval->m_values.emplace_back(key, std::forward<U>(value));
+
+      } else {
+         retval->m_values.emplace_back(key, std::forward<U>(value));
+         retval->m_values.push_back(existing);
+      }
+   }
+
+   return retval;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename U>
+auto persistent_map<K, V, H, E>::do_insert(const node *n, std::size_t hash, const K &key, U &&value,
+      unsigned shift, bool assign, bool &inserted) const -> node_ptr
+{
+   auto retval = std::make_shared<node>();
+
+   if (n == nullptr) {
+      retval->m_dataMap = 1u << fragment(hash, shift);
+      retval->m_values.emplace_back(key, std::forward<U>(value));
+      inserted = true;
+
+      return retval;
+   }
+
+   if (is_collision(shift)) {
+      retval->m_values.reserve(n->m_values.size() + 1);
+      inserted = true;
+
+      for (const auto &item : n->m_values) {
+         if (inserted && m_equal(item.first, key)) {
+            if (! assign) {
+               inserted = false;
+               return node_ptr();
+            }
+
+            retval->m_values.emplace_back(item.first, std::forward<U>(value));
+            inserted = false;
+
+         } else {
+            retval->m_values.push_back(item);
+         }
+      }
+
+      if (inserted) {
+         retval->m_values.emplace_back(key, std::forward<U>(value));
+      }
+
+      return retval;
+   }
+
+   const std::uint32_t bit = 1u << fragment(hash, shift);
+
+   retval->m_dataMap = n->m_dataMap;
+   retval->m_nodeMap = n->m_nodeMap;
+
+   if (n->m_dataMap & bit) {
+      const unsigned pos = index(n->m_dataMap, bit);
+      const value_type &existing = n->m_values[pos];
+
+      if (m_equal(existing.first, key)) {
+         if (! assign) {
+            return node_ptr();
+         }
+
+         retval->m_values.reserve(n->m_values.size());
+
+         for (unsigned i = 0; i < n->m_values.size(); ++i) {
+            if (i == pos) {
+               retval->m_values.emplace_back(existing.first, std::forward<U>(value));
+            } else {
+               retval->m_values.push_back(n->m_values[i]);
+            }
+         }
+
+         retval->m_children = n->m_children;
+
+         return retval;
+      }
+
+      // move the existing entry and the new one into a new child node
+      node_ptr child = merge(existing, m_hash(existing.first), key, std::forward<U>(value), hash,
+            shift + bits_per_level);
+
+      inserted = true;
+
+      retval->m_dataMap &= ~bit;
+      retval->m_nodeMap |= bit;
+
+      retval->m_values.reserve(n->m_values.size() - 1);
+
+      for (unsigned i = 0; i < n->m_values.size(); ++i) {
+         if (i != pos) {
+            retval->m_values.push_back(n->m_values[i]);
+         }
+      }
+
+      const unsigned childPos = index(retval->m_nodeMap, bit);
+
+      retval->m_children = n->m_children;
+      retval->m_children.insert(retval->m_children.begin() + childPos, std::move(child));
+
+      return retval;
+
+   } else if (n->m_nodeMap & bit) {
+      const unsigned pos = index(n->m_nodeMap, bit);
+
+      node_ptr child = do_insert(n->m_children[pos].get(), hash, key, std::forward<U>(value),
+            shift + bits_per_level, assign, inserted);
+
+      if (child == nullptr) {
+         // key already present and not replaced
+         return node_ptr();
+      }
+
+      retval->m_values   = n->m_values;
+      retval->m_children = n->m_children;
+      retval->m_children[pos] = std::move(child);
+
+      return retval;
+
+   } else {
+      const unsigned pos = index(n->m_dataMap, bit);
+
+      retval->m_dataMap |= bit;
+      retval->m_values.reserve(n->m_values.size() + 1);
+
+      for (unsigned i = 0; i <= n->m_values.size(); ++i) {
+         if (i == pos) {
+            retval->m_values.emplace_back(key, std::forward<U>(value));
+         }
+
+         if (i < n->m_values.size()) {
+            retval->m_values.push_back(n->m_values[i]);
+         }
+      }
+
+      retval->m_children = n->m_children;
+      inserted = true;
+
+      return retval;
+   }
+}
+
+template <typename K, typename V, typename H, typename E>
+auto persistent_map<K, V, H, E>::do_erase(const node *n, std::size_t hash, const K &key, unsigned shift,
+      bool &erased) const -> node_ptr
+{
+   if (is_collision(shift)) {
+      auto retval = std::make_shared<node>();
+
+      for (const auto &item : n->m_values) {
+         if (! erased && m_equal(item.first, key)) {
+            erased = true;
+         } else {
+            retval->m_values.push_back(item);
+         }
+      }
+
+      if (retval->m_values.empty()) {
+         return node_ptr();
+      }
+
+      return retval;
+   }
+
+   const std::uint32_t bit = 1u << fragment(hash, shift);
+
+   if (n->m_dataMap & bit) {
+      const unsigned pos = index(n->m_dataMap, bit);
+
+      if (! m_equal(n->m_values[pos].first, key)) {
+         return node_ptr();
+      }
+
+      erased = true;
+
+      if (n->m_values.size() == 1 && n->m_children.empty()) {
+         return node_ptr();
+      }
+
+      auto retval = std::make_shared<node>();
+
+      retval->m_dataMap = n->m_dataMap & ~bit;
+      retval->m_nodeMap = n->m_nodeMap;
+      retval->m_values.reserve(n->m_values.size() - 1);
+
+      for (unsigned i = 0; i < n->m_values.size(); ++i) {
+         if (i != pos) {
+            retval->m_values.push_back(n->m_values[i]);
+         }
+      }
+
+      retval->m_children = n->m_children;
+
+      return retval;
+
+   } else if (n->m_nodeMap & bit) {
+      const unsigned pos = index(n->m_nodeMap, bit);
+
+      node_ptr child = do_erase(n->m_children[pos].get(), hash, key, shift + bits_per_level, erased);
+
+      if (! erased) {
+         return node_ptr();
+      }
+
+      auto retval = std::make_shared<node>();
+
+      retval->m_dataMap = n->m_dataMap;
+      retval->m_nodeMap = n->m_nodeMap;
+
+      if (child != nullptr && (child->m_values.size() != 1 || ! child->m_children.empty())) {
+         retval->m_values   = n->m_values;
+         retval->m_children = n->m_children;
+         retval->m_children[pos] = std::move(child);
+
+         return retval;
+      }
+
+      // the child is empty or holds a single entry, remove it and pull the entry up
+      retval->m_nodeMap &= ~bit;
+
+      retval->m_children.reserve(n->m_children.size() - 1);
+
+      for (unsigned i = 0; i < n->m_children.size(); ++i) {
+         if (i != pos) {
+            retval->m_children.push_back(n->m_children[i]);
+         }
+      }
+
+      if (child == nullptr) {
+         retval->m_values = n->m_values;
+
+      } else {
+         retval->m_dataMap |= bit;
+
+         const unsigned valuePos = index(retval->m_dataMap, bit);
+         retval->m_values.reserve(n->m_values.size() + 1);
+
+         for (unsigned i = 0; i <= n->m_values.size(); ++i) {
+            if (i == valuePos) {
+               retval->m_values.push_back(child->m_values.front());
+            }
+
+            if (i < n->m_values.size()) {
+               retval->m_values.push_back(n->m_values[i]);
+            }
+         }
+      }
+
+      if (retval->m_values.empty() && retval->m_children.empty()) {
+         return node_ptr();
+      }
+
+      return retval;
+   }
+
+   return node_ptr();
+}
+
+}  // namespace libguarded
+
+#endif
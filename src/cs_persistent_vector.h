@@ -0,0 +1,471 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#ifndef CSLIBGUARDED_PERSISTENT_VECTOR_H
+#define CSLIBGUARDED_PERSISTENT_VECTOR_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_persistent_vector.h <CsLibGuarded/cs_persistent_vector.h>
+
+   This templated class is a sequence container implemented as a radix
+   balanced tree with a branching factor of 32. Nodes are immutable and
+   shared between copies, so copying a persistent_vector is O(1) and
+   modifying a copy only allocates the O(log n) nodes on the path to the
+   changed element. Elements at the end of the vector are kept in a
+   separate tail node so push_back and pop_back rarely touch the tree.
+
+   This class is designed to be used as the T of cow_guarded. The copy
+   made by cow_guarded::lock() shares all of its nodes with the existing
+   snapshots and each write through the handle only copies the path it
+   touches.
+
+   Elements are read only. Use set() to replace an element. All iterators
+   and references are invalidated by any modification of the vector they
+   were obtained from, but never by modifications made to another copy.
+
+   Concatenation and insertion in the middle are not supported, this is
+   not a relaxed radix balanced (RRB) tree.
+*/
+template <typename T>
+class persistent_vector
+{
+   private:
+      struct node;
+      using node_ptr = std::shared_ptr<const node>;
+
+   public:
+      using value_type      = T;
+      using size_type       = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using const_reference = const T &;
+
+      class const_iterator;
+      using iterator = const_iterator;
+
+      persistent_vector() = default;
+
+      persistent_vector(std::initializer_list<T> list);
+
+      [[nodiscard]] size_type size() const {
+         return m_size;
+      }
+
+      [[nodiscard]] bool empty() const {
+         return m_size == 0;
+      }
+
+      [[nodiscard]] const T &operator[](size_type pos) const;
+
+      /**
+        Returns the element at the given position. Throws std::out_of_range
+        if pos is not less than size().
+      */
+      [[nodiscard]] const T &at(size_type pos) const;
+
+      [[nodiscard]] const T &front() const {
+         return (*this)[0];
+      }
+
+      [[nodiscard]] const T &back() const {
+         return (*this)[m_size - 1];
+      }
+
+      [[nodiscard]] const_iterator begin() const {
+         return const_iterator(this, 0);
+      }
+
+      [[nodiscard]] const_iterator end() const {
+         return const_iterator(this, m_size);
+      }
+
+      [[nodiscard]] const_iterator cbegin() const {
+         return begin();
+      }
+
+      [[nodiscard]] const_iterator cend() const {
+         return end();
+      }
+
+      template <typename U>
+      void push_back(U &&value);
+
+      void pop_back();
+
+      /**
+        Replace the element at the given position. Throws std::out_of_range
+        if pos is not less than size().
+      */
+      template <typename U>
+      void set(size_type pos, U &&value);
+
+      void clear() {
+         m_root.reset();
+         m_tail.reset();
+         m_size  = 0;
+         m_shift = bits_per_level;
+      }
+
+   private:
+      static constexpr unsigned  bits_per_level = 5;
+      static constexpr size_type branch_factor  = size_type(1) << bits_per_level;
+      static constexpr size_type branch_mask    = branch_factor - 1;
+
+      // internal nodes only use m_children and leaf nodes only use m_values
+      struct node {
+         std::vector<node_ptr> m_children;
+         std::vector<T> m_values;
+      };
+
+      size_type tail_offset() const {
+         return m_size < branch_factor ? 0 : ((m_size - 1) >> bits_per_level) << bits_per_level;
+      }
+
+      const node *leaf_for(size_type pos) const;
+
+      node_ptr push_tail(unsigned level, const node *parent, node_ptr tail) const;
+      node_ptr pop_tail(unsigned level, const node *n) const;
+
+      static node_ptr new_path(unsigned level, node_ptr n);
+
+      template <typename U>
+      static node_ptr do_set(unsigned level, const node *n, size_type pos, U &&value);
+
+      node_ptr  m_root;
+      node_ptr  m_tail;
+      size_type m_size  = 0;
+      unsigned  m_shift = bits_per_level;
+
+   public:
+      /**
+        Bidirectional iterator over the elements of a persistent_vector.
+      */
+      class const_iterator
+      {
+         public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const T *;
+            using reference         = const T &;
+
+            const_iterator() = default;
+
+            reference operator*() const {
+               return (*m_vector)[m_pos];
+            }
+
+            pointer operator->() const {
+               return &(**this);
+            }
+
+            const_iterator &operator++() {
+               ++m_pos;
+               return *this;
+            }
+
+            const_iterator operator++(int) {
+               const_iterator retval = *this;
+               ++m_pos;
+
+               return retval;
+            }
+
+            const_iterator &operator--() {
+               --m_pos;
+               return *this;
+            }
+
+            const_iterator operator--(int) {
+               const_iterator retval = *this;
+               --m_pos;
+
+               return retval;
+            }
+
+            bool operator==(const const_iterator &other) const {
+               return m_pos == other.m_pos;
+            }
+
+         private:
+            const_iterator(const persistent_vector *vector, size_type pos)
+               : m_vector(vector), m_pos(pos)
+            {
+            }
+
+            const persistent_vector *m_vector = nullptr;
+            size_type m_pos = 0;
+
+            friend class persistent_vector;
+      };
+};
+
+template <typename T>
+persistent_vector<T>::persistent_vector(std::initializer_list<T> list)
+{
+   for (const auto &item : list) {
+      push_back(item);
+   }
+}
+
+template <typename T>
+auto persistent_vector<T>::leaf_for(size_type pos) const -> const node *
+{
+   if (pos >= tail_offset()) {
+      return m_tail.get();
+   }
+
+   const node *n = m_root.get();
+
+   for (unsigned level = m_shift; level > 0; level -= bits_per_level) {
+      n = n->m_children[(pos >> level) & branch_mask].get();
+   }
+
+   return n;
+}
+
+template <typename T>
+const T &persistent_vector<T>::operator[](size_type pos) const
+{
+   return leaf_for(pos)->m_values[pos & branch_mask];
+}
+
+template <typename T>
+const T &persistent_vector<T>::at(size_type pos) const
+{
+   if (pos >= m_size) {
+      throw std::out_of_range("persistent_vector::at: position out of range");
+   }
+
+   return (*this)[pos];
+}
+
+template <typename T>
+auto persistent_vector<T>::new_path(unsigned level, node_ptr n) -> node_ptr
+{
+   if (level == 0) {
+      return n;
+   }
+
+   auto retval = std::make_shared<node>();
+   retval->m_children.push_back(new_path(level - bits_per_level, std::move(n)));
+
+   return retval;
+}
+
+template <typename T>
+auto persistent_vector<T>::push_tail(unsigned level, const node *parent, node_ptr tail) const -> node_ptr
+{
+   // m_size still includes the elements of the tail being pushed
+   const size_type subIndex = ((m_size - 1) >> level) & branch_mask;
+
+   auto retval = std::make_shared<node>();
+
+   if (parent != nullptr) {
+      retval->m_children = parent->m_children;
+   }
+
+   node_ptr child;
+
+   if (level == bits_per_level) {
+      child = std::move(tail);
+
+   } else if (subIndex < retval->m_children.size()) {
+      child = push_tail(level - bits_per_level, retval->m_children[subIndex].get(), std::move(tail));
+
+   } else {
+      child = new_path(level - bits_per_level, std::move(tail));
+   }
+
+   if (subIndex < retval->m_children.size()) {
+      retval->m_children[subIndex] = std::move(child);
+   } else {
+      retval->m_children.push_back(std::move(child));
+   }
+
+   return retval;
+}
+
+template <typename T>
+template <typename U>
+void persistent_vector<T>::push_back(U &&value)
+{
+   auto newTail = std::make_shared<node>();
+
+   if (m_size - tail_offset() < branch_factor && m_tail != nullptr) {
+      // room left in the tail
+      newTail->m_values.reserve(m_tail->m_values.size() + 1);
+      newTail->m_values.insert(newTail->m_values.end(), m_tail->m_values.begin(), m_tail->m_values.end());
+      newTail->m_values.push_back(std::forward<U>(value));
+
+      m_tail = std::move(newTail);
+      ++m_size;
+
+      return;
+   }
+
+   newTail->m_values.reserve(branch_factor);
+   newTail->m_values.push_back(std::forward<U>(value));
+
+   if (m_tail != nullptr) {
+      // tail is full, move it into the tree
+      if ((m_size >> bits_per_level) > (size_type(1) << m_shift)) {
+         auto newRoot = std::make_shared<node>();
+
+         newRoot->m_children.push_back(m_root);
+         newRoot->m_children.push_back(new_path(m_shift, m_tail));
+
+         m_root   = std::move(newRoot);
+         m_shift += bits_per_level;
+
+      } else {
+         m_root = push_tail(m_shift, m_root.get(), m_tail);
+      }
+   }
+
+   m_tail = std::move(newTail);
+   ++m_size;
+}
+
+template <typename T>
+auto persistent_vector<T>::pop_tail(unsigned level, const node *n) const -> node_ptr
+{
+   const size_type subIndex = ((m_size - 2) >> level) & branch_mask;
+
+   if (level > bits_per_level) {
+      node_ptr child = pop_tail(level - bits_per_level, n->m_children[subIndex].get());
+
+      if (child == nullptr && subIndex == 0) {
+         return node_ptr();
+      }
+
+      auto retval = std::make_shared<node>();
+      retval->m_children = n->m_children;
+
+      if (child == nullptr) {
+         retval->m_children.pop_back();
+      } else {
+         retval->m_children[subIndex] = std::move(child);
+      }
+
+      return retval;
+
+   } else if (subIndex == 0) {
+      return node_ptr();
+
+   } else {
+      auto retval = std::make_shared<node>();
+
+      retval->m_children = n->m_children;
+      retval->m_children.pop_back();
+
+      return retval;
+   }
+}
+
+template <typename T>
+void persistent_vector<T>::pop_back()
+{
+   if (m_size == 0) {
+      return;
+   }
+
+   if (m_size == 1) {
+      clear();
+      return;
+   }
+
+   if (m_size - tail_offset() > 1) {
+      auto newTail = std::make_shared<node>();
+      newTail->m_values.reserve(m_tail->m_values.size() - 1);
+      newTail->m_values.insert(newTail->m_values.end(), m_tail->m_values.begin(), m_tail->m_values.end() - 1);
+
+      m_tail = std::move(newTail);
+      --m_size;
+
+      return;
+   }
+
+   // the tail becomes empty, the last leaf of the tree becomes the new tail
+   node_ptr newTail = m_root;
+
+   for (unsigned level = m_shift; level > 0; level -= bits_per_level) {
+      newTail = newTail->m_children[((m_size - 2) >> level) & branch_mask];
+   }
+
+   node_ptr newRoot = pop_tail(m_shift, m_root.get());
+
+   if (m_shift > bits_per_level && newRoot != nullptr && newRoot->m_children.size() == 1) {
+      newRoot  = newRoot->m_children.front();
+      m_shift -= bits_per_level;
+   }
+
+   m_tail = std::move(newTail);
+   m_root = std::move(newRoot);
+   --m_size;
+}
+
+template <typename T>
+template <typename U>
+auto persistent_vector<T>::do_set(unsigned level, const node *n, size_type pos, U &&value) -> node_ptr
+{
+   auto retval = std::make_shared<node>(*n);
+
+   if (level == 0) {
+      retval->m_values[pos & branch_mask] = std::forward<U>(value);
+   } else {
+      const size_type subIndex = (pos >> level) & branch_mask;
+      retval->m_children[subIndex] = do_set(level - bits_per_level, n->m_children[subIndex].get(), pos,
+            std::forward<U>(value));
+   }
+
+   return retval;
+}
+
+template <typename T>
+template <typename U>
+void persistent_vector<T>::set(size_type pos, U &&value)
+{
+   if (pos >= m_size) {
+      throw std::out_of_range("persistent_vector::set: position out of range");
+   }
+
+   if (pos >= tail_offset()) {
+      auto newTail = std::make_shared<node>(*m_tail);
+      newTail->m_values[pos & branch_mask] = std::forward<U>(value);
+
+      m_tail = std::move(newTail);
+
+   } else {
+      m_root = do_set(m_shift, m_root.get(), pos, std::forward<U>(value));
+   }
+}
+
+}  // namespace libguarded
+
+#endif
@@ -0,0 +1,118 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#ifndef CSLIBGUARDED_READER_INDICATOR_H
+#define CSLIBGUARDED_READER_INDICATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+/**
+   \headerfile cs_reader_indicator.h <CsLibGuarded/cs_reader_indicator.h>
+
+   Distributed count of active readers. Each thread is assigned one of a
+   fixed number of counters, each on its own cache line. Readers only
+   modify their own counter so concurrent readers on different threads do
+   not contend on a shared cache line. Checking for readers requires
+   scanning every counter and is intended for the writer side.
+
+   A reader which departs on a different thread than it arrived on leaves
+   one counter positive and another negative, only the total is
+   meaningful.
+*/
+class reader_indicator
+{
+   public:
+      static constexpr std::size_t slot_count = 64;
+
+      reader_indicator() = default;
+
+      reader_indicator(const reader_indicator &) = delete;
+      reader_indicator &operator=(const reader_indicator &) = delete;
+
+      /**
+        Register a reader for the current thread. Returns the counter which
+        must be passed to depart() when the reader is finished. The counter
+        may be released from any thread.
+      */
+      std::atomic<int> &arrive() {
+         std::atomic<int> &counter = m_slots[current_slot()].m_count;
+         ++counter;
+
+         return counter;
+      }
+
+      static void depart(std::atomic<int> &counter) {
+         --counter;
+      }
+
+      /**
+        Unregister a reader using the counter of the current thread.
+      */
+      void depart() {
+         --m_slots[current_slot()].m_count;
+      }
+
+      /**
+        Returns true if no readers are registered. Every reader which
+        arrived before this call is observed while departures may be
+        missed, so a total of zero means none of those readers is still
+        active. The caller must prevent new readers from arriving during
+        the scan.
+      */
+      bool empty() const {
+         int total = 0;
+
+         for (const auto &slot : m_slots) {
+            total += slot.m_count.load();
+         }
+
+         return total == 0;
+      }
+
+      /**
+        Returns the slot assigned to the calling thread. Slots are handed
+        out round robin the first time a thread asks for one.
+      */
+      static std::size_t current_slot() {
+         static std::atomic<std::size_t> nextSlot(0);
+         thread_local const std::size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % slot_count;
+
+         return slot;
+      }
+
+   private:
+      struct alignas(64) slot_type {
+         std::atomic<int> m_count = 0;
+      };
+
+      std::array<slot_type, slot_count> m_slots;
+};
+
+}  // namespace detail
+
+}  // namespace libguarded
+
+#endif
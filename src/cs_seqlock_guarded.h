@@ -0,0 +1,247 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_SEQLOCK_GUARDED_H
+#define CSLIBGUARDED_SEQLOCK_GUARDED_H
+
+#include "cs_spin_wait.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+/**
+   Copy of a trivially copyable object stored as atomic words and
+   validated with a sequence number. Writers must be serialized by the
+   caller. Readers do not acquire a lock and do not write to any shared
+   memory.
+*/
+template <typename T>
+class seqlock_storage
+{
+   static_assert(std::is_trivially_copyable_v<T>, "seqlock_storage requires a trivially copyable type");
+
+   public:
+      explicit seqlock_storage(const T &value);
+
+      seqlock_storage(const seqlock_storage &) = delete;
+      seqlock_storage &operator=(const seqlock_storage &) = delete;
+
+      // returns an empty optional if a write overlapped the read
+      std::optional<T> try_load() const;
+
+      // requires writers to be serialized
+      T load_locked() const;
+      void store_locked(const T &value);
+
+   private:
+      using word_type = std::uintptr_t;
+
+      static constexpr std::size_t word_count = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+
+      static T from_words(const std::array<word_type, word_count> &words);
+
+      alignas(64) std::atomic<std::uint64_t> m_sequence = 0;
+      std::array<std::atomic<word_type>, word_count> m_words;
+};
+
+template <typename T>
+seqlock_storage<T>::seqlock_storage(const T &value)
+{
+   std::array<word_type, word_count> buffer = {};
+   std::memcpy(buffer.data(), &value, sizeof(T));
+
+   for (std::size_t i = 0; i < word_count; ++i) {
+      m_words[i].store(buffer[i], std::memory_order_relaxed);
+   }
+}
+
+template <typename T>
+std::optional<T> seqlock_storage<T>::try_load() const
+{
+   std::array<word_type, word_count> buffer;
+
+   std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+
+   if ((before & 1) != 0) {
+      return std::nullopt;
+   }
+
+   for (std::size_t i = 0; i < word_count; ++i) {
+      buffer[i] = m_words[i].load(std::memory_order_relaxed);
+   }
+
+   // orders the data loads before the second sequence load
+   std::atomic_thread_fence(std::memory_order_acquire);
+
+   if (m_sequence.load(std::memory_order_relaxed) != before) {
+      return std::nullopt;
+   }
+
+   return from_words(buffer);
+}
+
+template <typename T>
+T seqlock_storage<T>::load_locked() const
+{
+   std::array<word_type, word_count> buffer;
+
+   for (std::size_t i = 0; i < word_count; ++i) {
+      buffer[i] = m_words[i].load(std::memory_order_relaxed);
+   }
+
+   return from_words(buffer);
+}
+
+template <typename T>
+void seqlock_storage<T>::store_locked(const T &value)
+{
+   std::array<word_type, word_count> buffer = {};
+   std::memcpy(buffer.data(), &value, sizeof(T));
+
+   std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+
+   // odd sequence marks a write in progress
+   m_sequence.store(sequence + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+
+   for (std::size_t i = 0; i < word_count; ++i) {
+      m_words[i].store(buffer[i], std::memory_order_relaxed);
+   }
+
+   m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <typename T>
+T seqlock_storage<T>::from_words(const std::array<word_type, word_count> &words)
+{
+   // T is not required to be default constructible
+   std::array<unsigned char, sizeof(T)> bytes;
+   std::memcpy(bytes.data(), words.data(), sizeof(T));
+
+   return std::bit_cast<T>(bytes);
+}
+
+}  // namespace detail
+
+/**
+   \headerfile cs_seqlock_guarded.h <CsLibGuarded/cs_seqlock_guarded.h>
+
+   This templated class wraps a small trivially copyable object. Readers
+   do not acquire a lock and do not write to any shared memory. Each
+   read copies the object and validates the copy against a sequence
+   number, retrying if a writer was active. Writers are serialized on the
+   mutex M and increment the sequence number before and after each
+   change.
+
+   Readers only ever receive a copy of the object. Reads are retried
+   while writes are in progress so this class is suited to data which is
+   written much less often than it is read.
+*/
+template <typename T, typename M = std::mutex>
+class seqlock_guarded
+{
+   static_assert(std::is_trivially_copyable_v<T>, "seqlock_guarded requires a trivially copyable type");
+
+   public:
+      template <typename... Us>
+      seqlock_guarded(Us &&... data);
+
+      seqlock_guarded(const seqlock_guarded &) = delete;
+      seqlock_guarded &operator=(const seqlock_guarded &) = delete;
+
+      [[nodiscard]] T load() const;
+
+      void store(const T &value);
+
+      /**
+         Calls func with a reference to a copy of the object and publishes
+         the result. Returns the value returned by func.
+      */
+      template <typename Func>
+      auto modify(Func &&func);
+
+   private:
+      detail::seqlock_storage<T> m_storage;
+
+      M m_mutex;
+};
+
+template <typename T, typename M>
+template <typename... Us>
+seqlock_guarded<T, M>::seqlock_guarded(Us &&... data)
+   : m_storage(T(std::forward<Us>(data)...))
+{
+}
+
+template <typename T, typename M>
+T seqlock_guarded<T, M>::load() const
+{
+   detail::spin_wait backoff;
+
+   while (true) {
+      if (std::optional<T> value = m_storage.try_load()) {
+         return *value;
+      }
+
+      backoff.wait();
+   }
+}
+
+template <typename T, typename M>
+void seqlock_guarded<T, M>::store(const T &value)
+{
+   std::lock_guard<M> lock(m_mutex);
+   m_storage.store_locked(value);
+}
+
+template <typename T, typename M>
+template <typename Func>
+auto seqlock_guarded<T, M>::modify(Func &&func)
+{
+   std::lock_guard<M> lock(m_mutex);
+
+   T value = m_storage.load_locked();
+
+   if constexpr (std::is_void_v<decltype(func(value))>) {
+      func(value);
+      m_storage.store_locked(value);
+
+   } else {
+      auto retval = func(value);
+      m_storage.store_locked(value);
+
+      return retval;
+   }
+}
+
+}  // namespace libguarded
+
+#endif
@@ -0,0 +1,209 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_SHARDED_GUARDED_H
+#define CSLIBGUARDED_SHARDED_GUARDED_H
+
+#include "cs_lock_guards.h"
+#include "cs_shared_guarded.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+// spreads the bits of a hash value so that the low bits select a shard evenly
+inline std::size_t mix_hash(std::size_t value)
+{
+   std::uint64_t x = value;
+
+   x ^= x >> 33;
+   x *= 0xff51afd7ed558ccdULL;
+   x ^= x >> 33;
+   x *= 0xc4ceb9fe1a85ec53ULL;
+   x ^= x >> 33;
+
+   return static_cast<std::size_t>(x);
+}
+
+}  // namespace detail
+
+/**
+   \headerfile cs_sharded_guarded.h <CsLibGuarded/cs_sharded_guarded.h>
+
+   This templated class holds N objects of type T, each protected by its
+   own shared_guarded. A key is mapped to one of the shards using Hash,
+   so threads which access different keys usually lock different shards
+   and do not wait for each other.
+
+   Typically T is a container such as std::unordered_map and each shard
+   holds the elements whose keys map to it. The default Hash is
+   std::hash of T::key_type. The hash value is mixed before selecting a
+   shard, so a hash function which returns its input, such as std::hash
+   for integers, still spreads keys across the shards.
+
+   The lock_all() methods lock every shard using lock_guards(), which
+   avoids deadlock with other threads locking several shards.
+*/
+template <typename T, std::size_t N, typename Hash = std::hash<typename T::key_type>,
+      typename M = std::shared_timed_mutex>
+class sharded_guarded
+{
+   static_assert(N > 0, "sharded_guarded requires at least one shard");
+
+   public:
+      using shard_type    = shared_guarded<T, M>;
+      using handle        = typename shard_type::handle;
+      using shared_handle = typename shard_type::shared_handle;
+
+      /**
+        Construct N guarded objects. Each object is constructed from a copy
+        of the given parameters.
+       */
+      template <typename... Us>
+      sharded_guarded(const Us &... data);
+
+      sharded_guarded(const sharded_guarded &) = delete;
+      sharded_guarded &operator=(const sharded_guarded &) = delete;
+
+      static constexpr std::size_t shard_count() {
+         return N;
+      }
+
+      template <typename Key>
+      [[nodiscard]] std::size_t shard_index(const Key &key) const;
+
+      shard_type &shard(std::size_t index) {
+         return m_shards[index];
+      }
+
+      const shard_type &shard(std::size_t index) const {
+         return m_shards[index];
+      }
+
+      // lock the shard which holds key
+      template <typename Key>
+      [[nodiscard]] handle lock(const Key &key);
+
+      template <typename Key>
+      [[nodiscard]] handle try_lock(const Key &key);
+
+      template <typename Key>
+      [[nodiscard]] shared_handle lock_shared(const Key &key) const;
+
+      template <typename Key>
+      [[nodiscard]] shared_handle try_lock_shared(const Key &key) const;
+
+      // lock every shard, the handles are in shard order
+      [[nodiscard]] std::array<handle, N> lock_all();
+      [[nodiscard]] std::array<shared_handle, N> lock_shared_all() const;
+
+   private:
+      template <typename Tuple, typename Handle>
+      static std::array<Handle, N> to_array(Tuple &&handles);
+
+      template <std::size_t... Is, typename... Us>
+      sharded_guarded(std::index_sequence<Is...>, const Us &... data);
+
+      std::array<shard_type, N> m_shards;
+      Hash m_hash;
+};
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename... Us>
+sharded_guarded<T, N, Hash, M>::sharded_guarded(const Us &... data)
+   : sharded_guarded(std::make_index_sequence<N>(), data...)
+{
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <std::size_t... Is, typename... Us>
+sharded_guarded<T, N, Hash, M>::sharded_guarded(std::index_sequence<Is...>, const Us &... data)
+   : m_shards{{(static_cast<void>(Is), shard_type(data...))...}}
+{
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Key>
+std::size_t sharded_guarded<T, N, Hash, M>::shard_index(const Key &key) const
+{
+   return detail::mix_hash(m_hash(key)) % N;
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Key>
+auto sharded_guarded<T, N, Hash, M>::lock(const Key &key) -> handle
+{
+   return m_shards[shard_index(key)].lock();
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Key>
+auto sharded_guarded<T, N, Hash, M>::try_lock(const Key &key) -> handle
+{
+   return m_shards[shard_index(key)].try_lock();
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Key>
+auto sharded_guarded<T, N, Hash, M>::lock_shared(const Key &key) const -> shared_handle
+{
+   return m_shards[shard_index(key)].lock_shared();
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Key>
+auto sharded_guarded<T, N, Hash, M>::try_lock_shared(const Key &key) const -> shared_handle
+{
+   return m_shards[shard_index(key)].try_lock_shared();
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+auto sharded_guarded<T, N, Hash, M>::lock_all() -> std::array<handle, N>
+{
+   auto handles = std::apply([](auto &... shards) { return lock_guards(shards...); }, m_shards);
+
+   return to_array<decltype(handles), handle>(std::move(handles));
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+auto sharded_guarded<T, N, Hash, M>::lock_shared_all() const -> std::array<shared_handle, N>
+{
+   auto handles = std::apply([](auto &... shards) { return lock_guards(as_reader(shards)...); }, m_shards);
+
+   return to_array<decltype(handles), shared_handle>(std::move(handles));
+}
+
+template <typename T, std::size_t N, typename Hash, typename M>
+template <typename Tuple, typename Handle>
+auto sharded_guarded<T, N, Hash, M>::to_array(Tuple &&handles) -> std::array<Handle, N>
+{
+   return std::apply([](auto &&... args) { return std::array<Handle, N>{{std::move(args)...}}; }, std::move(handles));
+}
+
+}  // namespace libguarded
+
+#endif
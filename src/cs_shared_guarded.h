@@ -37,6 +37,14 @@ namespace libguarded
 
    The handle returned by the various lock methods is moveable but not
    copyable.
+
+   The lock_upgrade methods require a mutex with upgrade ownership such as
+   upgrade_mutex. An upgrade_handle provides read access alongside other
+   readers and can be converted to a handle without any other thread
+   modifying the object in between.
+
+   For a small trivially copyable T which is read far more often than it
+   is written, seqlock_guarded provides reads without acquiring a lock.
 */
 template <typename T, typename M = std::shared_timed_mutex, typename L = std::shared_lock<M>>
 class shared_guarded
@@ -49,6 +57,8 @@ class shared_guarded
       using handle        = std::unique_ptr<T, deleter>;
       using shared_handle = std::unique_ptr<const T, shared_deleter>;
 
+      class upgrade_handle;
+
       template <typename... Us>
       shared_guarded(Us &&... data);
 
@@ -72,6 +82,16 @@ class shared_guarded
       template <class TimePoint>
       [[nodiscard]] shared_handle try_lock_shared_until(const TimePoint &timepoint) const;
 
+      // upgradeable access, requires M to support upgrade ownership
+      [[nodiscard]] upgrade_handle lock_upgrade();
+      [[nodiscard]] upgrade_handle try_lock_upgrade();
+
+      template <class Duration>
+      [[nodiscard]] upgrade_handle try_lock_upgrade_for(const Duration &duration);
+
+      template <class TimePoint>
+      [[nodiscard]] upgrade_handle try_lock_upgrade_until(const TimePoint &timepoint);
+
    private:
       T m_obj;
       mutable M m_mutex;
@@ -135,6 +155,102 @@ void shared_guarded<T, M, L>::shared_deleter::operator()(const T *)
    }
 }
 
+template <typename T, typename M, typename L>
+class shared_guarded<T, M, L>::upgrade_handle
+{
+   public:
+      upgrade_handle() = default;
+
+      upgrade_handle(const upgrade_handle &) = delete;
+      upgrade_handle &operator=(const upgrade_handle &) = delete;
+
+      upgrade_handle(upgrade_handle &&other)
+         : m_ptr(other.m_ptr), m_mutex(other.m_mutex)
+      {
+         other.m_ptr   = nullptr;
+         other.m_mutex = nullptr;
+      }
+
+      upgrade_handle &operator=(upgrade_handle &&other) {
+         if (this != &other) {
+            reset();
+
+            m_ptr   = other.m_ptr;
+            m_mutex = other.m_mutex;
+
+            other.m_ptr   = nullptr;
+            other.m_mutex = nullptr;
+         }
+
+         return *this;
+      }
+
+      ~upgrade_handle() {
+         reset();
+      }
+
+      const T &operator*() const {
+         return *m_ptr;
+      }
+
+      const T *operator->() const {
+         return m_ptr;
+      }
+
+      const T *get() const {
+         return m_ptr;
+      }
+
+      explicit operator bool() const {
+         return m_ptr != nullptr;
+      }
+
+      bool operator==(std::nullptr_t) const {
+         return m_ptr == nullptr;
+      }
+
+      /**
+         Wait for other readers to finish and return a handle with exclusive
+         access. This upgrade_handle is reset to null. Upgrading a null
+         upgrade_handle returns a null handle.
+      */
+      [[nodiscard]] handle upgrade() {
+         if (m_ptr == nullptr) {
+            return handle(nullptr, deleter());
+         }
+
+         m_mutex->unlock_upgrade_and_lock();
+
+         handle retval(m_ptr, deleter(std::unique_lock<M>(*m_mutex, std::adopt_lock)));
+
+         m_ptr   = nullptr;
+         m_mutex = nullptr;
+
+         return retval;
+      }
+
+      void reset() {
+         if (m_ptr != nullptr) {
+            m_mutex->unlock_upgrade();
+
+            m_ptr   = nullptr;
+            m_mutex = nullptr;
+         }
+      }
+
+   private:
+      friend class shared_guarded;
+
+      // mutex must be held with upgrade ownership
+      upgrade_handle(T *ptr, M &mutex)
+         : m_ptr(ptr), m_mutex(&mutex)
+      {
+      }
+
+      T *m_ptr   = nullptr;
+      M *m_mutex = nullptr;
+};
+
 template <typename T, typename M, typename L>
 template <typename... Us>
 shared_guarded<T, M, L>::shared_guarded(Us &&... data)
@@ -232,6 +348,45 @@ auto shared_guarded<T, M, L>::try_lock_shared_until(const TimePoint &tp) const -
    }
 }
 
+template <typename T, typename M, typename L>
+auto shared_guarded<T, M, L>::lock_upgrade() -> upgrade_handle
+{
+   m_mutex.lock_upgrade();
+   return upgrade_handle(&m_obj, m_mutex);
+}
+
+template <typename T, typename M, typename L>
+auto shared_guarded<T, M, L>::try_lock_upgrade() -> upgrade_handle
+{
+   if (m_mutex.try_lock_upgrade()) {
+      return upgrade_handle(&m_obj, m_mutex);
+   } else {
+      return upgrade_handle();
+   }
+}
+
+template <typename T, typename M, typename L>
+template <typename Duration>
+auto shared_guarded<T, M, L>::try_lock_upgrade_for(const Duration &d) -> upgrade_handle
+{
+   if (m_mutex.try_lock_upgrade_for(d)) {
+      return upgrade_handle(&m_obj, m_mutex);
+   } else {
+      return upgrade_handle();
+   }
+}
+
+template <typename T, typename M, typename L>
+template <typename TimePoint>
+auto shared_guarded<T, M, L>::try_lock_upgrade_until(const TimePoint &tp) -> upgrade_handle
+{
+   if (m_mutex.try_lock_upgrade_until(tp)) {
+      return upgrade_handle(&m_obj, m_mutex);
+   } else {
+      return upgrade_handle();
+   }
+}
+
 }  // namespace libguarded
 
 #endif
@@ -0,0 +1,85 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_SPIN_WAIT_H
+#define CSLIBGUARDED_SPIN_WAIT_H
+
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace libguarded
+{
+
+namespace detail
+{
+
+/**
+   Hint to the processor that the calling thread is in a spin loop.
+*/
+inline void cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   _mm_pause();
+
+#elif defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause();
+
+#elif defined(__aarch64__) || defined(__arm__)
+   asm volatile("yield");
+
+#endif
+}
+
+/**
+   Backoff for a spin loop. The first calls to wait() only pause the
+   processor, later calls yield the remainder of the time slice.
+*/
+class spin_wait
+{
+   public:
+      static constexpr int spin_limit = 64;
+
+      void wait() {
+         if (m_count < spin_limit) {
+            ++m_count;
+            cpu_relax();
+
+         } else {
+            std::this_thread::yield();
+         }
+      }
+
+      bool is_spinning() const {
+         return m_count < spin_limit;
+      }
+
+      void reset() {
+         m_count = 0;
+      }
+
+   private:
+      int m_count = 0;
+};
+
+}  // namespace detail
+
+}  // namespace libguarded
+
+#endif
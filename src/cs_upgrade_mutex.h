@@ -0,0 +1,184 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#ifndef CSLIBGUARDED_UPGRADE_MUTEX_H
+#define CSLIBGUARDED_UPGRADE_MUTEX_H
+
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+
+namespace libguarded
+{
+
+/**
+   \headerfile cs_upgrade_mutex.h <CsLibGuarded/cs_upgrade_mutex.h>
+
+   This class is a reader-writer mutex which also supports upgrade
+   ownership. An upgrade owner coexists with shared owners but excludes
+   other upgrade owners and exclusive owners. Upgrade ownership can be
+   converted to exclusive ownership without allowing any other thread to
+   modify the protected data in between.
+
+   The class meets the requirements of SharedTimedMutex and can be used
+   with shared_guarded::lock_upgrade().
+*/
+class upgrade_mutex
+{
+   public:
+      upgrade_mutex() = default;
+
+      upgrade_mutex(const upgrade_mutex &) = delete;
+      upgrade_mutex &operator=(const upgrade_mutex &) = delete;
+
+      // exclusive ownership
+      void lock() {
+         m_upgradeMutex.lock();
+         m_mutex.lock();
+      }
+
+      bool try_lock() {
+         if (! m_upgradeMutex.try_lock()) {
+            return false;
+         }
+
+         if (! m_mutex.try_lock()) {
+            m_upgradeMutex.unlock();
+            return false;
+         }
+
+         return true;
+      }
+
+      template <class Duration>
+      bool try_lock_for(const Duration &duration) {
+         return try_lock_until(std::chrono::steady_clock::now() + duration);
+      }
+
+      template <class TimePoint>
+      bool try_lock_until(const TimePoint &timepoint) {
+         if (! m_upgradeMutex.try_lock_until(timepoint)) {
+            return false;
+         }
+
+         if (! m_mutex.try_lock_until(timepoint)) {
+            m_upgradeMutex.unlock();
+            return false;
+         }
+
+         return true;
+      }
+
+      void unlock() {
+         m_mutex.unlock();
+         m_upgradeMutex.unlock();
+      }
+
+      // shared ownership
+      void lock_shared() {
+         m_mutex.lock_shared();
+      }
+
+      bool try_lock_shared() {
+         return m_mutex.try_lock_shared();
+      }
+
+      template <class Duration>
+      bool try_lock_shared_for(const Duration &duration) {
+         return m_mutex.try_lock_shared_for(duration);
+      }
+
+      template <class TimePoint>
+      bool try_lock_shared_until(const TimePoint &timepoint) {
+         return m_mutex.try_lock_shared_until(timepoint);
+      }
+
+      void unlock_shared() {
+         m_mutex.unlock_shared();
+      }
+
+      // upgrade ownership
+      void lock_upgrade() {
+         m_upgradeMutex.lock();
+         m_mutex.lock_shared();
+      }
+
+      bool try_lock_upgrade() {
+         if (! m_upgradeMutex.try_lock()) {
+            return false;
+         }
+
+         if (! m_mutex.try_lock_shared()) {
+            m_upgradeMutex.unlock();
+            return false;
+         }
+
+         return true;
+      }
+
+      template <class Duration>
+      bool try_lock_upgrade_for(const Duration &duration) {
+         return try_lock_upgrade_until(std::chrono::steady_clock::now() + duration);
+      }
+
+      template <class TimePoint>
+      bool try_lock_upgrade_until(const TimePoint &timepoint) {
+         if (! m_upgradeMutex.try_lock_until(timepoint)) {
+            return false;
+         }
+
+         if (! m_mutex.try_lock_shared_until(timepoint)) {
+            m_upgradeMutex.unlock();
+            return false;
+         }
+
+         return true;
+      }
+
+      void unlock_upgrade() {
+         m_mutex.unlock_shared();
+         m_upgradeMutex.unlock();
+      }
+
+      /**
+        Blocks until all shared owners have released the mutex. Readers
+        may acquire shared ownership while this method waits, however no
+        other thread can obtain upgrade or exclusive ownership.
+      */
+      void unlock_upgrade_and_lock() {
+         m_mutex.unlock_shared();
+         m_mutex.lock();
+      }
+
+      void unlock_upgrade_and_lock_shared() {
+         m_upgradeMutex.unlock();
+      }
+
+      void unlock_and_lock_upgrade() {
+         m_mutex.unlock();
+         m_mutex.lock_shared();
+      }
+
+   private:
+      // held by the upgrade owner or the exclusive owner
+      std::timed_mutex m_upgradeMutex;
+      std::shared_timed_mutex m_mutex;
+};
+
+}  // namespace libguarded
+
+#endif
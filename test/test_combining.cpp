@@ -0,0 +1,101 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include <cs_combining_guarded.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+TEST_CASE("Combining guarded basic", "[combining_guarded]")
+{
+   combining_guarded<std::vector<int>> data(3, 7);
+
+   REQUIRE(data.modify([](std::vector<int> &x) { return x.size(); }) == 3);
+
+   data.modify([](std::vector<int> &x) { x.push_back(9); });
+   REQUIRE(data.modify([](const std::vector<int> &x) { return x.back(); }) == 9);
+
+   // move only result
+   auto ptr = data.modify([](std::vector<int> &x) { return std::make_unique<int>(x.front()); });
+   REQUIRE(*ptr == 7);
+
+   REQUIRE_THROWS_AS(data.modify([](std::vector<int> &) -> int { throw std::runtime_error("modify"); }),
+         std::runtime_error);
+
+   REQUIRE(data.modify([](std::vector<int> &x) { return x.size(); }) == 4);
+}
+
+TEST_CASE("Combining guarded threads", "[combining_guarded]")
+{
+   combining_guarded<std::vector<int>> data;
+
+   constexpr int thread_count = 8;
+   constexpr int iterations   = 10000;
+
+   std::atomic<bool> mismatch = false;
+   std::atomic<int> combined  = 0;
+
+   std::vector<std::thread> threads;
+
+   for (int i = 0; i < thread_count; ++i) {
+      threads.emplace_back([&data, &mismatch, &combined, i]() {
+         const std::thread::id caller = std::this_thread::get_id();
+
+         for (int j = 0; j < iterations; ++j) {
+            // the functor may run on another thread, results must come back to this one
+            int value = i * iterations + j;
+
+            std::thread::id runner = data.modify([value](std::vector<int> &x) {
+               x.push_back(value);
+
+               // lets other threads publish while the mutex is held
+               std::this_thread::yield();
+
+               return std::this_thread::get_id();
+            });
+
+            if (runner != caller) {
+               ++combined;
+            }
+
+            if (data.modify([value](const std::vector<int> &x) { return x.size(); }) == 0) {
+               mismatch = true;
+            }
+         }
+      });
+   }
+
+   for (auto & th : threads) {
+      th.join();
+   }
+
+   REQUIRE(mismatch == false);
+
+   // under contention some operations are run by the thread which holds the mutex
+   REQUIRE(combined > 0);
+
+   std::vector<int> result = data.modify([](std::vector<int> &x) { return x; });
+   REQUIRE(result.size() == thread_count * iterations);
+}
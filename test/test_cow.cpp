@@ -17,12 +17,55 @@
 
 #include <cs_cow_guarded.h>
 
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
 using namespace libguarded;
 
+namespace {
+
+template <typename T>
+class counting_allocator
+{
+ public:
+   using value_type = T;
+
+   counting_allocator(std::atomic<int> &count)
+      : m_count(&count)
+   {
+   }
+
+   template <typename U>
+   counting_allocator(const counting_allocator<U> &other)
+      : m_count(other.m_count)
+   {
+   }
+
+   T *allocate(std::size_t n) {
+      ++(*m_count);
+      return std::allocator<T>().allocate(n);
+   }
+
+   void deallocate(T *ptr, std::size_t n) {
+      std::allocator<T>().deallocate(ptr, n);
+   }
+
+   template <typename U>
+   bool operator==(const counting_allocator<U> &other) const {
+      return m_count == other.m_count;
+   }
+
+   std::atomic<int> *m_count;
+};
+
+}  // namespace
+
 TEST_CASE("Cow guarded 1", "[cow_guarded]")
 {
    cow_guarded<int, std::timed_mutex> data(0);
@@ -128,3 +171,311 @@ TEST_CASE("Cow guarded 2", "[cow_guarded]")
 
    REQUIRE(*data_handle == 200000);
 }
+
+TEST_CASE("Cow guarded allocator", "[cow_guarded]")
+{
+   using alloc_type = counting_allocator<std::string>;
+
+   std::atomic<int> count(0);
+   alloc_type alloc(count);
+
+   cow_guarded<std::string, std::mutex, alloc_type> data(std::allocator_arg, alloc, "abc");
+
+   // object and control block share one allocation
+   REQUIRE(count == 1);
+
+   {
+      auto data_handle = data.lock();
+      *data_handle += "d";
+   }
+
+   REQUIRE(count == 2);
+   REQUIRE(*data.lock_shared() == "abcd");
+
+   {
+      auto data_handle = data.lock();
+      *data_handle = "xyz";
+      data_handle.cancel();
+   }
+
+   REQUIRE(count == 3);
+   REQUIRE(*data.lock_shared() == "abcd");
+
+   const alloc_type const_alloc(count);
+   cow_guarded<std::string, std::mutex, alloc_type> data2(std::allocator_arg, const_alloc, 3, 'x');
+   cow_guarded<std::string, std::mutex, alloc_type> data3(std::allocator_arg, alloc_type(count));
+
+   REQUIRE(count == 5);
+   REQUIRE(*data2.lock_shared() == "xxx");
+   REQUIRE(data3.lock_shared()->empty());
+}
+
+TEST_CASE("Cow guarded lazy handle", "[cow_guarded]")
+{
+   using alloc_type = counting_allocator<int>;
+
+   std::atomic<int> count(0);
+   cow_guarded<int, std::timed_mutex, alloc_type> data(std::allocator_arg, alloc_type(count), 1);
+
+   REQUIRE(count == 1);
+
+   auto before = data.lock_shared();
+
+   {
+      // read only access does not copy or publish
+      auto data_handle = data.lock_lazy();
+
+      REQUIRE(data_handle != nullptr);
+      REQUIRE(*std::as_const(data_handle) == 1);
+      REQUIRE(data_handle.is_modified() == false);
+   }
+
+   REQUIRE(count == 1);
+   REQUIRE(data.lock_shared() == before);
+
+   {
+      auto data_handle = data.try_lock_lazy();
+
+      REQUIRE(data_handle != nullptr);
+      ++(*data_handle);
+
+      REQUIRE(data_handle.is_modified() == true);
+      REQUIRE(*std::as_const(data_handle) == 2);
+      REQUIRE(*before == 1);
+
+      data_handle.cancel();
+      REQUIRE(data_handle == nullptr);
+   }
+
+   REQUIRE(count == 2);
+   REQUIRE(data.lock_shared() == before);
+
+   {
+      auto data_handle = data.try_lock_lazy_for(std::chrono::milliseconds(20));
+      *data_handle = 5;
+
+      std::thread th1([&data]() {
+         auto data_handle2 = data.try_lock_lazy_until(std::chrono::steady_clock::now() +
+                                                      std::chrono::milliseconds(20));
+         REQUIRE(data_handle2 == nullptr);
+      });
+
+      th1.join();
+   }
+
+   REQUIRE(count == 3);
+   REQUIRE(*data.lock_shared() == 5);
+   REQUIRE(*before == 1);
+
+   {
+      auto data_handle = data.lock_lazy();
+      auto moved       = std::move(data_handle);
+
+      *moved += 1;
+   }
+
+   REQUIRE(*data.lock_shared() == 6);
+}
+
+TEST_CASE("Cow guarded optimistic", "[cow_guarded]")
+{
+   cow_guarded<int> data(0);
+
+   data.modify_optimistic([](int &x) { ++x; });
+   REQUIRE(*data.lock_shared() == 1);
+
+   REQUIRE_THROWS_AS(data.modify_optimistic([](int &x) {
+      ++x;
+      throw std::runtime_error("failed");
+   }), std::runtime_error);
+
+   REQUIRE(*data.lock_shared() == 1);
+
+   auto retry = [&data]() {
+      for (int i = 0; i < 10000; ++i) {
+         data.modify_optimistic([](int &x) { ++x; });
+      }
+   };
+
+   std::atomic<int> funcCount(0);
+
+   auto merge = [&data, &funcCount]() {
+      for (int i = 0; i < 10000; ++i) {
+         data.modify_optimistic([&funcCount](int &x) {
+               ++funcCount;
+               ++x;
+            },
+            [](const int &base, const int &current, int &modified) {
+               modified = current + (modified - base);
+               return true;
+            });
+      }
+   };
+
+   std::thread th1(retry);
+   std::thread th2(retry);
+   std::thread th3(merge);
+
+   std::thread th4([&data]() {
+      for (int i = 0; i < 10000; ++i) {
+         auto data_handle = data.lock();
+         ++(*data_handle);
+      }
+   });
+
+   th1.join();
+   th2.join();
+   th3.join();
+   th4.join();
+
+   REQUIRE(*data.lock_shared() == 40001);
+
+   // a merging writer never calls its functor more than once per update
+   REQUIRE(funcCount == 10000);
+}
+
+TEST_CASE("Cow guarded versions", "[cow_guarded]")
+{
+   cow_guarded<int> data(0);
+
+   REQUIRE(data.version() == 0);
+
+   std::vector<std::pair<int, std::uint64_t>> received;
+
+   std::uint64_t id = data.subscribe([&received, &data](const cow_guarded<int>::shared_handle &ptr, std::uint64_t v) {
+      // reading from a subscriber is allowed
+      REQUIRE(data.lock_shared() != nullptr);
+      received.emplace_back(*ptr, v);
+   });
+
+   {
+      auto data_handle = data.lock();
+      ++(*data_handle);
+   }
+
+   {
+      // cancelled and read only writes do not publish
+      auto data_handle = data.lock();
+      data_handle.cancel();
+
+      auto lazy_handle = data.lock_lazy();
+      REQUIRE(*std::as_const(lazy_handle) == 1);
+   }
+
+   data.modify_optimistic([](int &x) { ++x; });
+
+   REQUIRE(data.version() == 2);
+   REQUIRE(received.size() == 2);
+   REQUIRE(received[0] == std::make_pair(1, std::uint64_t(1)));
+   REQUIRE(received[1] == std::make_pair(2, std::uint64_t(2)));
+
+   data.unsubscribe(id);
+
+   {
+      auto data_handle = data.lock();
+      ++(*data_handle);
+   }
+
+   REQUIRE(data.version() == 3);
+   REQUIRE(received.size() == 2);
+
+   std::atomic<std::uint64_t> lastSeen(data.version());
+
+   std::thread th1([&data, &lastSeen]() {
+      std::uint64_t v = lastSeen;
+
+      while (v < 103) {
+         std::uint64_t next = data.wait_for_change(v);
+
+         REQUIRE(next > v);
+         v = next;
+      }
+
+      lastSeen = v;
+   });
+
+   for (int i = 0; i < 100; ++i) {
+      auto data_handle = data.lock();
+      ++(*data_handle);
+   }
+
+   th1.join();
+
+   REQUIRE(lastSeen == 103);
+   REQUIRE(data.wait_for_change(0) == 103);
+}
+
+TEST_CASE("Cow guarded subscriber exception", "[cow_guarded]")
+{
+   cow_guarded<int> data(0);
+
+   std::vector<int> received;
+
+   data.subscribe([](const cow_guarded<int>::shared_handle &, std::uint64_t) {
+      throw std::runtime_error("subscriber");
+   });
+
+   data.subscribe([&received](const cow_guarded<int>::shared_handle &ptr, std::uint64_t) {
+      received.push_back(*ptr);
+   });
+
+   {
+      // published from the handle destructor
+      auto data_handle = data.lock();
+      ++(*data_handle);
+   }
+
+   {
+      auto lazy_handle = data.lock_lazy();
+      ++(*lazy_handle);
+   }
+
+   data.modify_optimistic([](int &x) { ++x; });
+
+   REQUIRE(data.version() == 3);
+   REQUIRE(received == std::vector<int>{1, 2, 3});
+}
+
+TEST_CASE("Cow guarded history", "[cow_guarded]")
+{
+   cow_guarded<int> data(0);
+
+   REQUIRE(data.history_size() == 0);
+   REQUIRE(*data.lock_shared_version(0) == 0);
+   REQUIRE(data.lock_shared_version(1) == nullptr);
+
+   {
+      auto data_handle = data.lock();
+      *data_handle = 100;
+   }
+
+   // no history retained by default
+   REQUIRE(data.lock_shared_version(0) == nullptr);
+   REQUIRE(*data.lock_shared_version(1) == 100);
+
+   data.set_history_size(3);
+
+   for (int i = 0; i < 10; ++i) {
+      auto data_handle = data.lock();
+      ++(*data_handle);
+   }
+
+   REQUIRE(data.version() == 11);
+
+   auto oldest = data.lock_shared_version(8);
+   REQUIRE(oldest != nullptr);
+   REQUIRE(*oldest == 107);
+
+   REQUIRE(*data.lock_shared_version(9) == 108);
+   REQUIRE(*data.lock_shared_version(11) == 110);
+   REQUIRE(data.lock_shared_version(7) == nullptr);
+   REQUIRE(data.lock_shared_version(12) == nullptr);
+
+   data.set_history_size(1);
+
+   REQUIRE(data.lock_shared_version(9) == nullptr);
+   REQUIRE(*data.lock_shared_version(10) == 109);
+
+   // handles remain valid after the version leaves the window
+   REQUIRE(*oldest == 107);
+}
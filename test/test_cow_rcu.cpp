@@ -0,0 +1,128 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#include <cs_cow_rcu_guarded.h>
+
+#include <string>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+TEST_CASE("Cow rcu traits", "[cow_rcu_guarded]")
+{
+   using TestType = cow_rcu_guarded<int, std::timed_mutex>;
+
+   REQUIRE(std::is_default_constructible_v<TestType> == true);
+   REQUIRE(std::is_constructible_v<TestType, int> == true);
+   REQUIRE(std::is_default_constructible_v<typename TestType::shared_handle> == true);
+   REQUIRE(std::is_move_constructible_v<typename TestType::shared_handle> == true);
+   REQUIRE(std::is_move_assignable_v<typename TestType::shared_handle> == true);
+   REQUIRE(std::is_copy_constructible_v<typename TestType::shared_handle> == false);
+}
+
+TEST_CASE("Cow rcu guarded 1", "[cow_rcu_guarded]")
+{
+   cow_rcu_guarded<std::string, std::timed_mutex> data("abc");
+
+   {
+      auto data_handle = data.lock();
+      *data_handle += "d";
+   }
+
+   {
+      auto data_handle = data.lock_shared();
+
+      REQUIRE(data_handle != nullptr);
+      REQUIRE(*data_handle == "abcd");
+
+      std::thread th1([&data]() {
+         auto data_handle2 = data.try_lock_shared();
+         REQUIRE(data_handle2 != nullptr);
+         REQUIRE(*data_handle2 == "abcd");
+      });
+
+      std::thread th2([&data]() {
+         auto data_handle2 = data.try_lock_shared_for(std::chrono::milliseconds(20));
+         REQUIRE(data_handle2 != nullptr);
+         REQUIRE(*data_handle2 == "abcd");
+      });
+
+      std::thread th3([&data]() {
+         auto data_handle2 = data.try_lock_shared_until(std::chrono::steady_clock::now() +
+                                                        std::chrono::milliseconds(20));
+         REQUIRE(data_handle2 != nullptr);
+         REQUIRE(*data_handle2 == "abcd");
+      });
+
+      th1.join();
+      th2.join();
+      th3.join();
+   }
+
+   {
+      auto data_handle = data.lock();
+      *data_handle = "xyz";
+
+      data_handle.cancel();
+      REQUIRE(data_handle == nullptr);
+   }
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == "abcd");
+   }
+}
+
+TEST_CASE("Cow rcu guarded 2", "[cow_rcu_guarded]")
+{
+   cow_rcu_guarded<int> data(0);
+
+   std::thread th1([&data]() {
+      for (int i = 0; i < 20000; ++i) {
+         auto data_handle = data.lock();
+         ++(*data_handle);
+      }
+   });
+
+   std::thread th2([&data]() {
+      for (int i = 0; i < 20000; ++i) {
+         auto data_handle = data.lock();
+         ++(*data_handle);
+      }
+   });
+
+   std::thread th3([&data]() {
+      int last_val = 0;
+
+      while (last_val != 40000) {
+         auto data_handle = data.lock_shared();
+         REQUIRE(last_val <= *data_handle);
+         last_val = *data_handle;
+      }
+   });
+
+   th1.join();
+   th2.join();
+   th3.join();
+
+   auto data_handle = data.lock_shared();
+
+   REQUIRE(*data_handle == 40000);
+}
@@ -17,7 +17,15 @@
 
 #include <cs_deferred_guarded.h>
 
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 #include <shared_mutex>
 using shared_mutex = std::shared_timed_mutex;
 
@@ -25,6 +33,34 @@ using shared_mutex = std::shared_timed_mutex;
 
 using namespace libguarded;
 
+namespace {
+
+// eagerly started coroutine, completion is observed through its captures
+struct detached_coroutine {
+   struct promise_type {
+      detached_coroutine get_return_object() {
+         return {};
+      }
+
+      std::suspend_never initial_suspend() noexcept {
+         return {};
+      }
+
+      std::suspend_never final_suspend() noexcept {
+         return {};
+      }
+
+      void return_void() {
+      }
+
+      void unhandled_exception() {
+         std::terminate();
+      }
+   };
+};
+
+}  // namespace
+
 TEST_CASE("Deferred guarded 1", "[deferred_guarded]")
 {
    deferred_guarded<int, shared_mutex> data(0);
@@ -127,3 +163,468 @@ TEST_CASE("Deferred guarded 2", "[deferred_guarded]")
 
    REQUIRE(*data_handle == 300000);
 }
+
+TEST_CASE("Deferred guarded ordering", "[deferred_guarded]")
+{
+   deferred_guarded<std::vector<int>, shared_mutex> data;
+
+   {
+      auto data_handle = data.lock_shared();
+
+      // exclusive access is not available, all writes are queued
+      std::thread th1([&data]() {
+         for (int i = 0; i < 1000; ++i) {
+            data.modify_detach([i](std::vector<int> &x) { x.push_back(i); });
+         }
+      });
+
+      th1.join();
+
+      REQUIRE(data_handle->empty() == true);
+   }
+
+   auto data_handle = data.lock_shared();
+
+   REQUIRE(data_handle->size() == 1000);
+
+   for (int i = 0; i < 1000; ++i) {
+      REQUIRE((*data_handle)[i] == i);
+   }
+}
+
+TEST_CASE("Deferred guarded queued tasks", "[deferred_guarded]")
+{
+   deferred_guarded<int, shared_mutex> data(0);
+
+   std::future<int> result;
+
+   {
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data, &result]() {
+         // move only capture
+         auto step = std::make_unique<int>(5);
+         data.modify_detach([step = std::move(step)](int & x) { x += *step; });
+
+         // capture too large for inline storage
+         std::array<int, 64> values = {};
+         values[63] = 10;
+         data.modify_detach([values](int & x) { x += values[63]; });
+
+         // exceptions from a detached write are discarded
+         data.modify_detach([](int &) { throw std::runtime_error("discarded"); });
+
+         result = data.modify_async([](int & x) { return ++x; });
+      });
+
+      th1.join();
+
+      REQUIRE(*data_handle == 0);
+   }
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == 16);
+   }
+
+   REQUIRE(result.get() == 16);
+}
+
+TEST_CASE("Deferred guarded executor", "[deferred_guarded]")
+{
+   deferred_guarded<int, shared_mutex> data(0);
+
+   std::vector<std::function<void()>> jobs;
+   data.set_executor([&jobs](std::function<void()> job) { jobs.push_back(std::move(job)); });
+
+   {
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data]() {
+         for (int i = 0; i < 10; ++i) {
+            data.modify_detach([](int & x) { ++x; });
+         }
+      });
+
+      th1.join();
+   }
+
+   // only one drain job is scheduled while it has not run
+   REQUIRE(jobs.size() == 1);
+
+   {
+      // readers do not apply queued writes
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == 0);
+   }
+
+   jobs[0]();
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == 10);
+   }
+}
+
+TEST_CASE("Deferred guarded executor job not run", "[deferred_guarded]")
+{
+   std::vector<std::function<void()>> jobs;
+
+   {
+      deferred_guarded<int, shared_mutex> data(0);
+      data.set_executor([&jobs](std::function<void()> job) { jobs.push_back(std::move(job)); });
+
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data]() {
+         data.modify_detach([](int & x) { ++x; });
+      });
+
+      th1.join();
+   }
+
+   // destruction does not wait for the job, running it afterwards does nothing
+   REQUIRE(jobs.size() == 1);
+   jobs[0]();
+}
+
+TEST_CASE("Deferred guarded inline executor", "[deferred_guarded]")
+{
+   deferred_guarded<int, shared_mutex> data(0);
+   data.set_executor([](std::function<void()> job) { job(); });
+
+   {
+      auto data_handle = data.lock_shared();
+
+      // the drain job runs inline on this thread and finds the lock held
+      REQUIRE(data.modify_detach([](int & x) { ++x; }) == true);
+      REQUIRE(data.modify_detach([](int & x) { ++x; }) == true);
+
+      REQUIRE(*data_handle == 0);
+      REQUIRE(data.stats().depth == 2);
+   }
+
+   // releasing the handle submitted the drain
+   REQUIRE(data.stats().depth == 0);
+   REQUIRE(*data.lock_shared() == 2);
+}
+
+TEST_CASE("Deferred guarded drain thread", "[deferred_guarded]")
+{
+   deferred_guarded<int, shared_mutex> data(0);
+   data.start_drain_thread();
+
+   {
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data]() {
+         for (int i = 0; i < 1000; ++i) {
+            data.modify_detach([](int & x) { ++x; });
+         }
+      });
+
+      th1.join();
+   }
+
+   while (*data.lock_shared() != 1000) {
+      std::this_thread::yield();
+   }
+
+   data.stop_drain_thread();
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == 1000);
+   }
+}
+
+TEST_CASE("Deferred guarded keyed writes", "[deferred_guarded]")
+{
+   deferred_guarded<std::vector<int>, shared_mutex> data;
+
+   {
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data]() {
+         data.modify_detach(1, [](std::vector<int> &x) { x.push_back(10); });
+         data.modify_detach([](std::vector<int> &x) { x.push_back(20); });
+
+         for (int i = 11; i < 20; ++i) {
+            // replaces the queued write for key 1
+            data.modify_detach(1, [i](std::vector<int> &x) { x.push_back(i); });
+         }
+
+         data.modify_detach(2, [](std::vector<int> &x) { x.push_back(30); });
+      });
+
+      th1.join();
+   }
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == std::vector<int>{19, 20, 30});
+   }
+
+   // key 1 is no longer queued, a new write is appended
+   {
+      auto data_handle = data.lock_shared();
+
+      std::thread th1([&data]() {
+         data.modify_detach(1, [](std::vector<int> &x) { x.push_back(40); });
+      });
+
+      th1.join();
+   }
+
+   auto data_handle = data.lock_shared();
+   REQUIRE(*data_handle == std::vector<int>{19, 20, 30, 40});
+}
+
+TEST_CASE("Deferred guarded pending limit", "[deferred_guarded]")
+{
+   using guarded_type = deferred_guarded<std::vector<int>, shared_mutex>;
+
+   SECTION("reject") {
+      guarded_type data;
+      data.set_pending_limit(2, guarded_type::overflow_policy::reject);
+
+      {
+         auto data_handle = data.lock_shared();
+
+         std::thread th1([&data]() {
+            REQUIRE(data.modify_detach([](std::vector<int> &x) { x.push_back(1); }) == true);
+            REQUIRE(data.modify_detach([](std::vector<int> &x) { x.push_back(2); }) == true);
+            REQUIRE(data.modify_detach([](std::vector<int> &x) { x.push_back(3); }) == false);
+
+            // no write with this key is queued, a new entry needs room
+            REQUIRE(data.modify_detach(1, [](std::vector<int> &x) { x.push_back(4); }) == false);
+
+            auto result = data.modify_async([](std::vector<int> &x) { return x.size(); });
+            REQUIRE_THROWS_AS(result.get(), pending_limit_exceeded);
+         });
+
+         th1.join();
+
+         auto stats = data.stats();
+         REQUIRE(stats.depth == 2);
+         REQUIRE(stats.high_water_mark == 2);
+         REQUIRE(stats.drain_count == 0);
+      }
+
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == std::vector<int>{1, 2});
+
+      auto stats = data.stats();
+      REQUIRE(stats.depth == 0);
+      REQUIRE(stats.high_water_mark == 2);
+      REQUIRE(stats.drain_count == 1);
+   }
+
+   SECTION("replace queued key") {
+      guarded_type data;
+      data.set_pending_limit(2, guarded_type::overflow_policy::reject);
+
+      {
+         auto data_handle = data.lock_shared();
+
+         std::thread th1([&data]() {
+            REQUIRE(data.modify_detach(1, [](std::vector<int> &x) { x.push_back(1); }) == true);
+            REQUIRE(data.modify_detach([](std::vector<int> &x) { x.push_back(2); }) == true);
+
+            // the queue is full, replacing a queued key does not need room
+            REQUIRE(data.modify_detach(1, [](std::vector<int> &x) { x.push_back(3); }) == true);
+            REQUIRE(data.modify_detach(2, [](std::vector<int> &x) { x.push_back(4); }) == false);
+         });
+
+         th1.join();
+
+         REQUIRE(data.stats().depth == 2);
+      }
+
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == std::vector<int>{3, 2});
+   }
+
+   SECTION("apply synchronously") {
+      guarded_type data;
+      data.set_pending_limit(1, guarded_type::overflow_policy::apply_synchronously);
+
+      std::thread th1;
+
+      {
+         auto data_handle = data.lock_shared();
+
+         th1 = std::thread([&data]() {
+            data.modify_detach([](std::vector<int> &x) { x.push_back(1); });
+
+            // blocks until the reader is done, then applies both writes in order
+            data.modify_detach([](std::vector<int> &x) { x.push_back(2); });
+         });
+
+         while (data.stats().depth != 1) {
+            std::this_thread::yield();
+         }
+      }
+
+      th1.join();
+
+      auto data_handle = data.lock_shared();
+      REQUIRE(*data_handle == std::vector<int>{1, 2});
+   }
+
+   SECTION("block") {
+      guarded_type data;
+      data.set_pending_limit(4, guarded_type::overflow_policy::block);
+      data.start_drain_thread();
+
+      std::thread th1;
+
+      {
+         auto data_handle = data.lock_shared();
+
+         th1 = std::thread([&data]() {
+            for (int i = 0; i < 100; ++i) {
+               data.modify_detach([i](std::vector<int> &x) { x.push_back(i); });
+            }
+         });
+
+         while (data.stats().depth != 4) {
+            std::this_thread::yield();
+         }
+      }
+
+      th1.join();
+
+      while (data.stats().depth != 0) {
+         std::this_thread::yield();
+      }
+
+      REQUIRE(data.stats().high_water_mark <= 4);
+
+      auto data_handle = data.lock_shared();
+      REQUIRE(data_handle->size() == 100);
+
+      for (int i = 0; i < 100; ++i) {
+         REQUIRE((*data_handle)[i] == i);
+      }
+   }
+}
+
+TEST_CASE("Deferred guarded coroutine", "[deferred_guarded]")
+{
+   using guarded_type = deferred_guarded<int, shared_mutex>;
+
+   SECTION("uncontended") {
+      guarded_type data(0);
+      int result = 0;
+
+      [](guarded_type & d, int & r) -> detached_coroutine {
+         r = co_await d.co_modify([](int & x) { return ++x; });
+      }(data, result);
+
+      // applied without suspending
+      REQUIRE(result == 1);
+   }
+
+   SECTION("queued") {
+      guarded_type data(0);
+
+      std::atomic<int> result   = 0;
+      std::atomic<bool> failed  = false;
+      std::thread::id resumedOn;
+
+      {
+         auto data_handle = data.lock_shared();
+
+         std::thread th1([&]() {
+            [](guarded_type & d, std::atomic<int> & r, std::atomic<bool> & f, std::thread::id & id) -> detached_coroutine {
+               r = co_await d.co_modify([](int & x) { return x += 10; });
+               id = std::this_thread::get_id();
+
+               try {
+                  co_await d.co_modify([](int &) { throw std::runtime_error("failed"); });
+               } catch (std::runtime_error &) {
+                  f = true;
+               }
+            }(data, result, failed, resumedOn);
+         });
+
+         th1.join();
+
+         // the coroutine is suspended until the write is applied
+         REQUIRE(result == 0);
+      }
+
+      // this reader applies the write and resumes the coroutine
+      auto data_handle = data.lock_shared();
+
+      REQUIRE(*data_handle == 10);
+      REQUIRE(result == 10);
+      REQUIRE(failed == true);
+      REQUIRE(resumedOn == std::this_thread::get_id());
+   }
+}
+
+TEST_CASE("Deferred guarded fairness", "[deferred_guarded]")
+{
+   using guarded_type = deferred_guarded<int, shared_mutex>;
+
+   auto check_reader_waits = [](guarded_type & data) {
+      std::atomic<bool> done = false;
+      int value = 0;
+
+      std::thread th1;
+
+      {
+         auto data_handle = data.lock_shared();
+
+         std::thread th2([&data]() {
+            for (int i = 0; i < 3; ++i) {
+               data.modify_detach([](int & x) { ++x; });
+            }
+         });
+
+         th2.join();
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+         th1 = std::thread([&]() {
+            auto handle = data.lock_shared();
+
+            value = *handle;
+            done  = true;
+         });
+
+         // the new reader waits for the queue to drain, which needs this lock released
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         REQUIRE(done == false);
+      }
+
+      th1.join();
+
+      REQUIRE(done == true);
+      REQUIRE(value == 3);
+   };
+
+   SECTION("max pending") {
+      guarded_type data(0);
+      data.set_fairness(3);
+
+      check_reader_waits(data);
+   }
+
+   SECTION("max staleness") {
+      guarded_type data(0);
+      data.set_fairness(0, std::chrono::milliseconds(1));
+
+      check_reader_waits(data);
+   }
+
+   SECTION("drain thread") {
+      guarded_type data(0);
+      data.set_fairness(3);
+      data.start_drain_thread();
+
+      check_reader_waits(data);
+   }
+}
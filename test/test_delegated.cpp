@@ -0,0 +1,85 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include <cs_delegated_guarded.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+TEST_CASE("Delegated guarded basic", "[delegated_guarded]")
+{
+   delegated_guarded<std::map<int, int>> data;
+
+   data.modify([](std::map<int, int> &x) { x[1] = 10; });
+   REQUIRE(data.modify([](std::map<int, int> &x) { return x.at(1); }) == 10);
+
+   // the functor runs on the server thread
+   std::thread::id server_id = data.modify([](std::map<int, int> &) { return std::this_thread::get_id(); });
+   REQUIRE(server_id != std::this_thread::get_id());
+   REQUIRE(data.modify([](std::map<int, int> &) { return std::this_thread::get_id(); }) == server_id);
+
+   REQUIRE_THROWS_AS(data.modify([](std::map<int, int> &x) { return x.at(2); }), std::out_of_range);
+
+   // the server sleeps while idle and is woken by the next operation
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   REQUIRE(data.modify([](std::map<int, int> &x) { return x.size(); }) == 1);
+}
+
+TEST_CASE("Delegated guarded threads", "[delegated_guarded]")
+{
+   delegated_guarded<std::map<int, int>> data;
+
+   constexpr int thread_count = 8;
+   constexpr int iterations   = 5000;
+
+   std::atomic<bool> mismatch = false;
+   std::vector<std::thread> threads;
+
+   for (int i = 0; i < thread_count; ++i) {
+      threads.emplace_back([&data, &mismatch, i]() {
+         for (int j = 0; j < iterations; ++j) {
+            int count = data.modify([i](std::map<int, int> &x) { return ++x[i]; });
+
+            if (count != j + 1) {
+               mismatch = true;
+            }
+         }
+      });
+   }
+
+   for (auto & th : threads) {
+      th.join();
+   }
+
+   REQUIRE(mismatch == false);
+
+   std::map<int, int> result = data.modify([](std::map<int, int> &x) { return x; });
+
+   REQUIRE(result.size() == thread_count);
+
+   for (auto [key, value] : result) {
+      REQUIRE(value == iterations);
+   }
+}
@@ -15,9 +15,15 @@
 *
 ***********************************************************************/
 
+#include <cs_adaptive_mutex.h>
+#include <cs_cohort_mutex.h>
 #include <cs_cow_guarded.h>
+#include <cs_cow_rcu_guarded.h>
+#include <cs_distributed_shared_mutex.h>
+#include <cs_mcs_mutex.h>
 #include <cs_plain_guarded.h>
 #include <cs_shared_guarded.h>
+#include <cs_upgrade_mutex.h>
 #include <cs_lock_guards.h>
 #include <mutex>
 
@@ -30,7 +36,7 @@
 using namespace libguarded;
 
 TEMPLATE_TEST_CASE("exclusive lock traits", "[exclusive_lock]", plain_guarded<int>,
-		shared_guarded<int>, cow_guarded<int>)
+		shared_guarded<int>, cow_guarded<int>, cow_rcu_guarded<int>)
 {
    REQUIRE(std::is_default_constructible_v<TestType> == true);
    REQUIRE(std::is_constructible_v<TestType, int> == true);
@@ -40,7 +46,10 @@ TEMPLATE_TEST_CASE("exclusive lock traits", "[exclusive_lock]", plain_guarded<in
 }
 
 TEMPLATE_TEST_CASE("exclusive lock basic", "[exclusive_lock]", plain_guarded<int>,
-		shared_guarded<int>, cow_guarded<int>)
+		(plain_guarded<int, adaptive_mutex>), (plain_guarded<int, mcs_mutex>), (plain_guarded<int, cohort_mutex<>>),
+		shared_guarded<int>,
+		cow_guarded<int>, cow_rcu_guarded<int>,
+		(shared_guarded<int, distributed_shared_mutex>), (shared_guarded<int, upgrade_mutex>))
 {
    SECTION("initialize")
    {
@@ -85,7 +94,10 @@ TEMPLATE_TEST_CASE("exclusive lock basic", "[exclusive_lock]", plain_guarded<int
 }
 
 TEMPLATE_TEST_CASE("exclusive try_lock", "[exclusive_lock]", (plain_guarded<int, std::timed_mutex>),
-                  (shared_guarded<int, std::timed_mutex>), (cow_guarded<int, std::shared_timed_mutex>))
+                  (plain_guarded<int, adaptive_mutex>), (plain_guarded<int, cohort_mutex<fake_topology<2>>>),
+                  (shared_guarded<int, std::timed_mutex>), (cow_guarded<int, std::shared_timed_mutex>),
+                  (cow_rcu_guarded<int, std::timed_mutex>), (shared_guarded<int, distributed_shared_mutex>),
+                  (shared_guarded<int, upgrade_mutex>))
 {
    TestType data = 1;
 
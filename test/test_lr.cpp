@@ -115,3 +115,63 @@ TEST_CASE("LR guarded 2", "[lr_guarded]")
 
    REQUIRE(*data_handle == 200000);
 }
+
+TEST_CASE("LR guarded versions", "[lr_guarded]")
+{
+   lr_guarded<int> data(0);
+
+   REQUIRE(data.version() == 0);
+
+   {
+      auto data_handle = data.lock_shared();
+      REQUIRE(data_handle.get_deleter().version() == 0);
+   }
+
+   std::uint64_t v1 = data.modify([](int & x) { ++x; });
+   std::uint64_t v2 = data.modify([](int & x) { ++x; });
+
+   REQUIRE(v1 == 1);
+   REQUIRE(v2 == 2);
+   REQUIRE(data.version() == 2);
+
+   {
+      auto data_handle = data.lock_shared_at_least(v2);
+
+      REQUIRE(data_handle != nullptr);
+      REQUIRE(*data_handle == 2);
+      REQUIRE(data_handle.get_deleter().version() == 2);
+   }
+
+   {
+      auto data_handle = data.lock_shared_at_least(v2 + 1);
+      REQUIRE(data_handle == nullptr);
+   }
+
+   std::thread th1([&data]() {
+      for (int i = 0; i < 10000; ++i) {
+         std::uint64_t v = data.modify([](int & x) { ++x; });
+
+         auto data_handle = data.lock_shared_at_least(v);
+         REQUIRE(data_handle != nullptr);
+         REQUIRE(data_handle.get_deleter().version() >= v);
+      }
+   });
+
+   std::thread th2([&data]() {
+      std::uint64_t last_version = 0;
+
+      while (last_version < 10002) {
+         auto data_handle = data.lock_shared();
+         std::uint64_t v  = data_handle.get_deleter().version();
+
+         REQUIRE(last_version <= v);
+         REQUIRE(*data_handle == static_cast<int>(v));
+         last_version = v;
+      }
+   });
+
+   th1.join();
+   th2.join();
+
+   REQUIRE(data.version() == 10002);
+}
@@ -0,0 +1,410 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include <cs_adaptive_mutex.h>
+#include <cs_cohort_mutex.h>
+#include <cs_deferred_guarded.h>
+#include <cs_distributed_shared_mutex.h>
+#include <cs_mcs_mutex.h>
+#include <cs_ordered_guarded.h>
+#include <cs_plain_guarded.h>
+#include <cs_shared_guarded.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+TEST_CASE("Distributed shared mutex", "[distributed_shared_mutex]")
+{
+   distributed_shared_mutex mutex;
+
+   SECTION("shared and exclusive") {
+      mutex.lock_shared();
+      REQUIRE(mutex.try_lock_shared() == true);
+
+      std::atomic<bool> th1_ok = false;
+
+      std::thread th1([&mutex, &th1_ok]() {
+         th1_ok = ! mutex.try_lock() && ! mutex.try_lock_for(std::chrono::milliseconds(10));
+      });
+
+      th1.join();
+      REQUIRE(th1_ok == true);
+
+      mutex.unlock_shared();
+      mutex.unlock_shared();
+
+      REQUIRE(mutex.try_lock() == true);
+
+      std::atomic<bool> th2_ok = false;
+
+      std::thread th2([&mutex, &th2_ok]() {
+         th2_ok = ! mutex.try_lock_shared() && ! mutex.try_lock_shared_for(std::chrono::milliseconds(10));
+      });
+
+      th2.join();
+      REQUIRE(th2_ok == true);
+
+      mutex.unlock();
+   }
+
+   SECTION("unlock shared on another thread") {
+      mutex.lock_shared();
+
+      std::thread th1([&mutex]() { mutex.unlock_shared(); });
+      th1.join();
+
+      REQUIRE(mutex.try_lock() == true);
+      mutex.unlock();
+   }
+}
+
+TEST_CASE("Distributed shared mutex guarded", "[distributed_shared_mutex]")
+{
+   shared_guarded<int, distributed_shared_mutex> shared(0);
+   ordered_guarded<int, distributed_shared_mutex> ordered(0);
+   deferred_guarded<int, distributed_shared_mutex> deferred(0);
+
+   std::atomic<bool> mismatch = false;
+   std::vector<std::thread> threads;
+
+   for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&]() {
+         for (int j = 0; j < 10000; ++j) {
+            {
+               auto handle = shared.lock();
+               ++(*handle);
+            }
+
+            ordered.modify([](int & x) { ++x; });
+            deferred.modify_detach([](int & x) { ++x; });
+
+            {
+               auto handle = shared.lock_shared();
+
+               if (*handle < 0) {
+                  mismatch = true;
+               }
+            }
+         }
+      });
+   }
+
+   for (auto & th : threads) {
+      th.join();
+   }
+
+   REQUIRE(mismatch == false);
+   REQUIRE(*shared.lock_shared() == 40000);
+   REQUIRE(*ordered.lock_shared() == 40000);
+   REQUIRE(*deferred.lock_shared() == 40000);
+}
+
+TEST_CASE("Adaptive mutex", "[adaptive_mutex]")
+{
+   plain_guarded<int, adaptive_mutex> data(0);
+
+   std::vector<std::thread> threads;
+
+   for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&data, i]() {
+         for (int j = 0; j < 10000; ++j) {
+            auto handle = data.lock();
+            ++(*handle);
+
+            if (i == 0 && j % 1000 == 0) {
+               // long critical section, other threads stop spinning and sleep
+               std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+         }
+      });
+   }
+
+   for (auto & th : threads) {
+      th.join();
+   }
+
+   REQUIRE(*data.lock() == 40000);
+}
+
+TEST_CASE("MCS mutex", "[mcs_mutex]")
+{
+   SECTION("try_lock and nested locks") {
+      mcs_mutex mutex1;
+      mcs_mutex mutex2;
+
+      mutex1.lock();
+      REQUIRE(mutex2.try_lock() == true);
+
+      std::atomic<bool> th1_ok = false;
+
+      std::thread th1([&mutex1, &mutex2, &th1_ok]() {
+         th1_ok = ! mutex1.try_lock() && ! mutex2.try_lock();
+      });
+
+      th1.join();
+      REQUIRE(th1_ok == true);
+
+      mutex1.unlock();
+      mutex2.unlock();
+
+      REQUIRE(mutex1.try_lock() == true);
+      mutex1.unlock();
+   }
+
+   SECTION("first in first out") {
+      mcs_mutex mutex;
+      std::vector<int> order;
+
+      mutex.lock();
+
+      std::vector<std::thread> threads;
+
+      for (int i = 0; i < 4; ++i) {
+         std::atomic<bool> started = false;
+
+         threads.emplace_back([&mutex, &order, &started, i]() {
+            started = true;
+
+            mutex.lock();
+            order.push_back(i);
+            mutex.unlock();
+         });
+
+         while (! started) {
+            std::this_thread::yield();
+         }
+
+         // give the thread time to enter the queue before starting the next one
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+
+      mutex.unlock();
+
+      for (auto & th : threads) {
+         th.join();
+      }
+
+      REQUIRE(order == std::vector<int>{0, 1, 2, 3});
+   }
+
+   SECTION("short lived threads") {
+      // a thread may exit while the thread which handed it the mutex still uses its node
+      mcs_mutex mutex;
+      int count = 0;
+
+      for (int round = 0; round < 50; ++round) {
+         std::vector<std::thread> threads;
+
+         for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&mutex, &count]() {
+               mutex.lock();
+               ++count;
+               mutex.unlock();
+            });
+         }
+
+         for (auto & th : threads) {
+            th.join();
+         }
+      }
+
+      REQUIRE(count == 200);
+   }
+
+   SECTION("guarded") {
+      plain_guarded<int, mcs_mutex> data(0);
+
+      std::vector<std::thread> threads;
+
+      for (int i = 0; i < 8; ++i) {
+         threads.emplace_back([&data]() {
+            for (int j = 0; j < 10000; ++j) {
+               ++(*data.lock());
+            }
+         });
+      }
+
+      for (auto & th : threads) {
+         th.join();
+      }
+
+      REQUIRE(*data.lock() == 80000);
+   }
+}
+
+TEST_CASE("Cohort mutex topology", "[cohort_mutex]")
+{
+   linux_topology topology;
+
+   REQUIRE(topology.node_count() >= 1);
+   REQUIRE(topology.current_node() < topology.node_count());
+
+   fake_topology<2> fake;
+
+   REQUIRE(fake.node_count() == 2);
+   REQUIRE(fake.current_node() == 0);
+
+   std::atomic<bool> th1_ok = false;
+
+   std::thread th1([&fake, &th1_ok]() {
+      fake_topology<2>::set_current_node(1);
+      th1_ok = fake.current_node() == 1;
+   });
+
+   th1.join();
+   REQUIRE(th1_ok == true);
+   REQUIRE(fake.current_node() == 0);
+}
+
+TEST_CASE("Cohort mutex", "[cohort_mutex]")
+{
+   using topology = fake_topology<2>;
+
+   SECTION("same node first") {
+      cohort_mutex<topology> mutex;
+      std::vector<int> order;
+
+      mutex.lock();
+
+      // waits on the global mutex
+      std::thread th1([&mutex, &order]() {
+         topology::set_current_node(1);
+
+         mutex.lock();
+         order.push_back(1);
+         mutex.unlock();
+      });
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+      // waits on the mutex of node zero, receives the mutex first
+      std::thread th2([&mutex, &order]() {
+         mutex.lock();
+         order.push_back(2);
+         mutex.unlock();
+      });
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+      mutex.unlock();
+
+      th1.join();
+      th2.join();
+
+      REQUIRE(order == std::vector<int>{2, 1});
+   }
+
+   SECTION("handoff limit") {
+      constexpr std::uint32_t max_handoffs = 4;
+
+      cohort_mutex<topology> mutex(max_handoffs);
+
+      // node zero acquisitions after the main thread releases the mutex, protected by mutex
+      std::uint32_t run  = 0;
+      std::uint32_t seen = 0;
+
+      std::atomic<bool> th1_started = false;
+      std::atomic<bool> done        = false;
+      bool in_time                  = false;
+
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+      mutex.lock();
+
+      std::thread th1([&]() {
+         topology::set_current_node(1);
+         th1_started = true;
+
+         mutex.lock();
+         seen    = run;
+         in_time = std::chrono::steady_clock::now() < deadline;
+         done    = true;
+         mutex.unlock();
+      });
+
+      // these wait on the mutex of node zero, so each unlock on node zero finds a waiter
+      std::vector<std::thread> threads;
+
+      for (int i = 0; i < 4; ++i) {
+         threads.emplace_back([&]() {
+            while (! done && std::chrono::steady_clock::now() < deadline) {
+               mutex.lock();
+
+               if (! done) {
+                  ++run;
+               }
+
+               mutex.unlock();
+            }
+         });
+      }
+
+      while (! th1_started) {
+         std::this_thread::yield();
+      }
+
+      // give th1 time to queue on the global mutex
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+      mutex.unlock();
+
+      th1.join();
+
+      for (auto &thread : threads) {
+         thread.join();
+      }
+
+      REQUIRE(in_time == true);
+
+      // node zero keeps the global mutex for at most max_handoffs acquisitions, counting the main thread
+      REQUIRE(seen <= max_handoffs);
+   }
+
+   SECTION("guarded") {
+      plain_guarded<int, cohort_mutex<topology>> plain(0);
+      shared_guarded<int, cohort_shared_mutex<topology>> shared(0);
+
+      std::vector<std::thread> threads;
+
+      for (int i = 0; i < 8; ++i) {
+         threads.emplace_back([&plain, &shared, i]() {
+            topology::set_current_node(i);
+
+            for (int j = 0; j < 10000; ++j) {
+               ++(*plain.lock());
+               ++(*shared.lock());
+
+               auto handle = shared.lock_shared();
+            }
+         });
+      }
+
+      for (auto & th : threads) {
+         th.join();
+      }
+
+      REQUIRE(*plain.lock() == 80000);
+      REQUIRE(*shared.lock_shared() == 80000);
+   }
+}
@@ -18,6 +18,7 @@
 #include <cs_ordered_guarded.h>
 
 #include <atomic>
+#include <stdexcept>
 #include <thread>
 
 #include <shared_mutex>
@@ -173,3 +174,47 @@ TEST_CASE("Ordered guarded 2", "[ordered_guarded]")
 
    REQUIRE(data.modify([](const int &x) { return x; }) == 200000);
 }
+
+TEST_CASE("Ordered guarded optimistic read", "[ordered_guarded]")
+{
+   struct pair_type {
+      int first;
+      int second;
+   };
+
+   ordered_guarded<pair_type, shared_mutex> data(0, 0);
+
+   std::atomic<bool> mismatch(false);
+
+   std::thread th1([&data]() {
+      for (int i = 0; i < 20000; ++i) {
+         data.modify([](pair_type &value) {
+            ++value.first;
+            ++value.second;
+         });
+      }
+   });
+
+   std::thread th2([&data, &mismatch]() {
+      int last_val = 0;
+
+      while (last_val != 20000) {
+         pair_type value = data.read_optimistic([](const pair_type &value) { return value; });
+
+         if (value.first != value.second || value.first < last_val) {
+            mismatch = true;
+         }
+
+         last_val = value.first;
+      }
+   });
+
+   th1.join();
+   th2.join();
+
+   REQUIRE(mismatch == false);
+
+   // a writer which throws leaves the object readable
+   REQUIRE_THROWS(data.modify([](pair_type &) { throw std::runtime_error("modify"); }));
+   REQUIRE(data.read_optimistic([](const pair_type &value) { return value.first; }, 1) == 20000);
+}
@@ -0,0 +1,280 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+
+#include <cs_cow_guarded.h>
+#include <cs_persistent_map.h>
+#include <cs_persistent_vector.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+namespace {
+
+// forces long runs of identical hash prefixes and full collisions
+struct poor_hash {
+   std::size_t operator()(int value) const {
+      return static_cast<std::size_t>(value % 7);
+   }
+};
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Persistent map basic", "[persistent_map]", (persistent_map<int, std::string>),
+      (persistent_map<int, std::string, poor_hash>))
+{
+   TestType data;
+
+   REQUIRE(data.empty() == true);
+   REQUIRE(data.begin() == data.end());
+   REQUIRE(data.find(1) == data.end());
+
+   REQUIRE(data.insert(1, "one") == true);
+   REQUIRE(data.insert(1, "uno") == false);
+   REQUIRE(data.insert_or_assign(2, "two") == true);
+   REQUIRE(data.insert_or_assign(2, "dos") == false);
+
+   REQUIRE(data.size() == 2);
+   REQUIRE(data.at(1) == "one");
+   REQUIRE(data.at(2) == "dos");
+   REQUIRE(data.contains(3) == false);
+   REQUIRE_THROWS_AS(data.at(3), std::out_of_range);
+
+   TestType copy = data;
+
+   REQUIRE(data.erase(1) == 1);
+   REQUIRE(data.erase(1) == 0);
+   REQUIRE(data.size() == 1);
+
+   REQUIRE(copy.size() == 2);
+   REQUIRE(copy.at(1) == "one");
+}
+
+TEST_CASE("Persistent map duplicate in collision bucket", "[persistent_map]")
+{
+   // 1, 8 and 15 share a full hash with poor_hash
+   persistent_map<int, std::string, poor_hash> data;
+
+   REQUIRE(data.insert(1, "one") == true);
+   REQUIRE(data.insert(8, "eight") == true);
+   REQUIRE(data.insert(15, "fifteen") == true);
+
+   REQUIRE(data.insert(8, "acht") == false);
+   REQUIRE(data.insert(1, "uno") == false);
+
+   REQUIRE(data.size() == 3);
+   REQUIRE(data.at(1) == "one");
+   REQUIRE(data.at(8) == "eight");
+   REQUIRE(data.at(15) == "fifteen");
+
+   std::size_t count = 0;
+
+   for (auto iter = data.begin(); iter != data.end(); ++iter) {
+      ++count;
+   }
+
+   REQUIRE(count == 3);
+}
+
+TEMPLATE_TEST_CASE("Persistent map random", "[persistent_map]", (persistent_map<int, int>),
+      (persistent_map<int, int, poor_hash>))
+{
+   std::mt19937 engine(42);
+   std::uniform_int_distribution<int> keys(0, 2000);
+
+   TestType data;
+   std::map<int, int> expected;
+
+   std::vector<std::pair<TestType, std::map<int, int>>> snapshots;
+
+   for (int i = 0; i < 20000; ++i) {
+      int key = keys(engine);
+
+      if (i % 3 == 0) {
+         REQUIRE(data.erase(key) == expected.erase(key));
+      } else {
+         REQUIRE(data.insert_or_assign(key, i) == (expected.count(key) == 0));
+         expected[key] = i;
+      }
+
+      if (i % 2000 == 0) {
+         snapshots.emplace_back(data, expected);
+      }
+   }
+
+   snapshots.emplace_back(data, expected);
+
+   for (const auto &[snapshot, contents] : snapshots) {
+      REQUIRE(snapshot.size() == contents.size());
+
+      std::size_t count = 0;
+
+      for (const auto &[key, value] : snapshot) {
+         REQUIRE(contents.at(key) == value);
+         ++count;
+      }
+
+      REQUIRE(count == contents.size());
+
+      for (const auto &[key, value] : contents) {
+         auto iter = snapshot.find(key);
+
+         REQUIRE(iter != snapshot.end());
+         REQUIRE(iter->second == value);
+      }
+   }
+
+   // iteration resumes correctly from an iterator returned by find
+   for (const auto &[key, value] : expected) {
+      std::size_t count = 0;
+
+      for (auto iter = data.find(key); iter != data.end(); ++iter) {
+         ++count;
+      }
+
+      REQUIRE(count >= 1);
+      REQUIRE(count <= data.size());
+   }
+}
+
+TEST_CASE("Persistent vector", "[persistent_vector]")
+{
+   persistent_vector<int> data;
+   std::vector<int> expected;
+
+   std::vector<std::pair<persistent_vector<int>, std::vector<int>>> snapshots;
+
+   for (int i = 0; i < 40000; ++i) {
+      data.push_back(i);
+      expected.push_back(i);
+
+      if (i % 997 == 0) {
+         data.set(i / 2, -i);
+         expected[i / 2] = -i;
+
+         snapshots.emplace_back(data, expected);
+      }
+   }
+
+   REQUIRE(data.size() == expected.size());
+   REQUIRE(data.front() == expected.front());
+   REQUIRE(data.back() == expected.back());
+   REQUIRE_THROWS_AS(data.at(expected.size()), std::out_of_range);
+
+   while (expected.size() > 5) {
+      for (int i = 0; i < 37 && ! expected.empty(); ++i) {
+         data.pop_back();
+         expected.pop_back();
+      }
+
+      REQUIRE(data.size() == expected.size());
+      REQUIRE(data.back() == expected.back());
+
+      snapshots.emplace_back(data, expected);
+   }
+
+   for (const auto &[snapshot, contents] : snapshots) {
+      REQUIRE(snapshot.size() == contents.size());
+      REQUIRE(std::equal(snapshot.begin(), snapshot.end(), contents.begin(), contents.end()) == true);
+   }
+
+   while (! data.empty()) {
+      data.pop_back();
+   }
+
+   data.push_back(5);
+   REQUIRE(data.size() == 1);
+   REQUIRE(data[0] == 5);
+}
+
+TEST_CASE("Persistent map in cow_guarded", "[persistent_map]")
+{
+   cow_guarded<persistent_map<int, int>> data;
+
+   {
+      auto data_handle = data.lock();
+
+      for (int i = 0; i < 1000; ++i) {
+         data_handle->insert_or_assign(i, i);
+      }
+   }
+
+   auto snapshot = data.lock_shared();
+
+   std::thread th1([&data]() {
+      for (int i = 0; i < 1000; ++i) {
+         auto data_handle = data.lock();
+         data_handle->insert_or_assign(i, data_handle->at(i) + 1);
+      }
+   });
+
+   std::thread th2([&data]() {
+      for (int i = 0; i < 1000; ++i) {
+         auto data_handle = data.lock();
+         data_handle->erase(i + 1000);
+         data_handle->insert_or_assign(i + 1000, i);
+      }
+   });
+
+   th1.join();
+   th2.join();
+
+   REQUIRE(snapshot->size() == 1000);
+   REQUIRE(snapshot->at(10) == 10);
+
+   auto current = data.lock_shared();
+
+   REQUIRE(current->size() == 2000);
+   REQUIRE(current->at(10) == 11);
+   REQUIRE(current->at(1010) == 10);
+}
+
+TEST_CASE("Persistent vector in cow_guarded", "[persistent_vector]")
+{
+   cow_guarded<persistent_vector<std::string>> data;
+
+   {
+      auto data_handle = data.lock();
+
+      for (int i = 0; i < 100; ++i) {
+         data_handle->push_back(std::to_string(i));
+      }
+   }
+
+   auto snapshot = data.lock_shared();
+
+   {
+      auto data_handle = data.lock();
+      data_handle->set(50, "changed");
+      data_handle->pop_back();
+   }
+
+   REQUIRE(snapshot->size() == 100);
+   REQUIRE((*snapshot)[50] == "50");
+
+   auto current = data.lock_shared();
+
+   REQUIRE(current->size() == 99);
+   REQUIRE((*current)[50] == "changed");
+}
@@ -16,6 +16,7 @@
 ***********************************************************************/
 
 #include <cs_cow_guarded.h>
+#include <cs_distributed_shared_mutex.h>
 #include <cs_plain_guarded.h>
 #include <cs_shared_guarded.h>
 #include <mutex>
@@ -35,7 +36,8 @@ TEMPLATE_TEST_CASE("read lock traits", "[read_lock]",
    REQUIRE(std::is_move_assignable_v<typename TestType::shared_handle> == true);
 }
 
-TEMPLATE_TEST_CASE("read lock basic", "[read_lock]", shared_guarded<int>, cow_guarded<int>)
+TEMPLATE_TEST_CASE("read lock basic", "[read_lock]", shared_guarded<int>, cow_guarded<int>,
+		(shared_guarded<int, distributed_shared_mutex>))
 {
    SECTION("test multiple read lock")
    {
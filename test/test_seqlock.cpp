@@ -0,0 +1,115 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include <cs_seqlock_guarded.h>
+
+#include <atomic>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+namespace {
+
+struct quote {
+   quote(int bid, int ask, char venue)
+      : m_bid(bid), m_ask(ask), m_venue(venue)
+   {
+   }
+
+   int m_bid;
+   int m_ask;
+   char m_venue;
+};
+
+}  // namespace
+
+TEST_CASE("Seqlock guarded 1", "[seqlock_guarded]")
+{
+   seqlock_guarded<quote> data(100, 101, 'a');
+
+   quote value = data.load();
+
+   REQUIRE(value.m_bid == 100);
+   REQUIRE(value.m_ask == 101);
+   REQUIRE(value.m_venue == 'a');
+
+   data.store(quote(200, 202, 'b'));
+   REQUIRE(data.load().m_ask == 202);
+
+   int spread = data.modify([](quote &q) {
+      q.m_bid += 1;
+      return q.m_ask - q.m_bid;
+   });
+
+   REQUIRE(spread == 1);
+   REQUIRE(data.load().m_bid == 201);
+
+   data.modify([](quote &q) { q.m_venue = 'c'; });
+   REQUIRE(data.load().m_venue == 'c');
+}
+
+TEST_CASE("Seqlock guarded 2", "[seqlock_guarded]")
+{
+   struct triple {
+      long m_a;
+      long m_b;
+      long m_c;
+   };
+
+   seqlock_guarded<triple> data(triple{0, 0, 0});
+
+   std::atomic<bool> torn(false);
+   std::atomic<bool> done(false);
+
+   auto writer = [&data]() {
+      for (int i = 0; i < 20000; ++i) {
+         data.modify([](triple &t) {
+            ++t.m_a;
+            ++t.m_b;
+            ++t.m_c;
+         });
+      }
+   };
+
+   std::thread th1(writer);
+   std::thread th2(writer);
+
+   std::thread th3([&]() {
+      long last = 0;
+
+      while (! done) {
+         triple value = data.load();
+
+         if (value.m_a != value.m_b || value.m_b != value.m_c || value.m_a < last) {
+            torn = true;
+         }
+
+         last = value.m_a;
+      }
+   });
+
+   th1.join();
+   th2.join();
+
+   done = true;
+   th3.join();
+
+   REQUIRE(torn == false);
+   REQUIRE(data.load().m_c == 40000);
+}
@@ -0,0 +1,151 @@
+/***********************************************************************
+*
+* Copyright (c) 2016-2026 Ansel Sermersheim
+*
+* This file is part of CsLibGuarded.
+*
+* CsLibGuarded is free software which is released under the BSD 2-Clause license.
+* For license details refer to the LICENSE provided with this project.
+*
+* CsLibGuarded is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* https://opensource.org/licenses/BSD-2-Clause
+*
+***********************************************************************/
+
+#include <cs_sharded_guarded.h>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace libguarded;
+
+TEST_CASE("Sharded guarded basic", "[sharded_guarded]")
+{
+   using map_type = std::unordered_map<int, std::string>;
+
+   sharded_guarded<map_type, 8> data;
+
+   REQUIRE(data.shard_count() == 8);
+
+   for (int i = 0; i < 100; ++i) {
+      auto handle = data.lock(i);
+      handle->emplace(i, std::to_string(i));
+   }
+
+   REQUIRE(data.lock_shared(42)->at(42) == "42");
+
+   // consecutive integer keys are spread over every shard
+   std::set<std::size_t> used;
+
+   for (int i = 0; i < 100; ++i) {
+      std::size_t index = data.shard_index(i);
+
+      REQUIRE(index < 8);
+      REQUIRE(data.shard(index).lock_shared()->count(i) == 1);
+
+      used.insert(index);
+   }
+
+   REQUIRE(used.size() == 8);
+
+   {
+      auto handles = data.lock_all();
+
+      std::size_t total = 0;
+
+      for (auto &handle : handles) {
+         total += handle->size();
+      }
+
+      REQUIRE(total == 100);
+
+      std::atomic<bool> th1_ok = false;
+
+      std::thread th1([&data, &th1_ok]() {
+         th1_ok = data.try_lock(1) == nullptr && data.try_lock_shared(2) == nullptr;
+      });
+
+      th1.join();
+      REQUIRE(th1_ok == true);
+   }
+
+   {
+      auto handles = data.lock_shared_all();
+      REQUIRE(handles[data.shard_index(7)]->at(7) == "7");
+
+      std::atomic<bool> th1_ok = false;
+
+      std::thread th1([&data, &th1_ok]() {
+         th1_ok = data.try_lock_shared(3) != nullptr && data.try_lock(3) == nullptr;
+      });
+
+      th1.join();
+      REQUIRE(th1_ok == true);
+   }
+}
+
+TEST_CASE("Sharded guarded construct", "[sharded_guarded]")
+{
+   struct identity {
+      std::size_t operator()(std::size_t value) const {
+         return value;
+      }
+   };
+
+   // every shard is constructed from a copy of the arguments
+   sharded_guarded<std::vector<std::size_t>, 4, identity> data(3, 5);
+
+   for (std::size_t i = 0; i < data.shard_count(); ++i) {
+      REQUIRE(*data.shard(i).lock_shared() == std::vector<std::size_t>{5, 5, 5});
+   }
+
+   REQUIRE(data.lock(std::size_t(10))->size() == 3);
+}
+
+TEST_CASE("Sharded guarded threads", "[sharded_guarded]")
+{
+   sharded_guarded<std::unordered_map<int, int>, 16> data;
+
+   std::vector<std::thread> threads;
+
+   for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&data, i]() {
+         for (int j = 0; j < 10000; ++j) {
+            int key = j % 100;
+
+            ++(*data.lock(key))[key];
+
+            if (j % 1000 == i) {
+               // whole map operations while other threads lock single shards
+               auto handles = data.lock_all();
+               ++(*handles[0])[-1];
+            }
+         }
+      });
+   }
+
+   for (auto & th : threads) {
+      th.join();
+   }
+
+   int total = 0;
+
+   for (auto &handle : data.lock_shared_all()) {
+      for (auto [key, value] : *handle) {
+         if (key >= 0) {
+            total += value;
+         }
+      }
+   }
+
+   REQUIRE(total == 40000);
+}
@@ -16,6 +16,7 @@
 ***********************************************************************/
 
 #include <cs_shared_guarded.h>
+#include <cs_upgrade_mutex.h>
 
 #include <atomic>
 #include <thread>
@@ -220,3 +221,68 @@ TEST_CASE("Shared guarded 2", "[shared_guarded]")
    
    REQUIRE(*data_handle == 200000);
 }
+
+TEST_CASE("Shared guarded upgrade", "[shared_guarded]")
+{
+   shared_guarded<int, upgrade_mutex> data(0);
+
+   {
+      auto upgrade_handle = data.lock_upgrade();
+
+      REQUIRE(upgrade_handle != nullptr);
+      REQUIRE(*upgrade_handle == 0);
+
+      std::atomic<bool> th1_ok(false);
+
+      std::thread th1([&data, &th1_ok]() {
+         // readers coexist with the upgrade owner, other upgraders and writers do not
+         th1_ok = data.try_lock_shared() != nullptr && data.try_lock_upgrade() == nullptr &&
+               data.try_lock_upgrade_for(std::chrono::milliseconds(10)) == nullptr && data.try_lock() == nullptr;
+      });
+
+      th1.join();
+      REQUIRE(th1_ok == true);
+
+      auto data_handle = upgrade_handle.upgrade();
+
+      REQUIRE(upgrade_handle == nullptr);
+      REQUIRE(data_handle != nullptr);
+
+      *data_handle = 5;
+   }
+
+   REQUIRE(*data.lock_shared() == 5);
+
+   std::atomic<bool> modified(false);
+
+   auto increment = [&data, &modified]() {
+      for (int i = 0; i < 10000; ++i) {
+         auto upgrade_handle = data.lock_upgrade();
+         int value = *upgrade_handle;
+
+         auto data_handle = upgrade_handle.upgrade();
+
+         if (*data_handle != value) {
+            modified = true;
+         }
+
+         *data_handle = value + 1;
+      }
+   };
+
+   std::thread th1(increment);
+   std::thread th2(increment);
+
+   std::thread th3([&data]() {
+      for (int i = 0; i < 10000; ++i) {
+         auto data_handle = data.lock_shared();
+      }
+   });
+
+   th1.join();
+   th2.join();
+   th3.join();
+
+   REQUIRE(modified == false);
+   REQUIRE(*data.lock_shared() == 20005);
+}